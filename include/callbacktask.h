@@ -8,20 +8,22 @@
 #ifndef THREADPOOLUNIVERSE_CALLBACKTASK_H
 #define THREADPOOLUNIVERSE_CALLBACKTASK_H
 
+#include "moveonlyfunction.h"
 #include "taskbase.h"
 
-#include <functional>
-
 namespace threadpooluniverse
 {
     /**
      * @brief A task that executes a callback function.
+     *
+     * The callbacks are move-only, so they can capture objects such as 'std::unique_ptr'. Lambdas
+     * whose captures fit to the inline buffer of MoveOnlyFunction are stored without allocating.
      */
     class CallbackTask : public TaskBase
     {
     public:
-        using ExecuteCallback = std::function<void()>;
-        using ErrorCallback = std::function<void()>;
+        using ExecuteCallback = MoveOnlyFunction<void()>;
+        using ErrorCallback = MoveOnlyFunction<void()>;
 
         /**
          * @brief Constructs a CallbackTask with a unique task ID and a callback function.
@@ -0,0 +1,445 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_CHANNEL_H
+#define THREADPOOLUNIVERSE_CHANNEL_H
+
+#include "moveonlyfunction.h"
+#include "taskbase.h"
+#include "threadpool.h"
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief Channel is a bounded multi-producer multi-consumer queue for passing values between
+     * tasks.
+     *
+     * A task that cannot send because the channel is full, or cannot receive because it is empty,
+     * does not block its worker thread. Instead it parks a continuation with 'asyncSend()' or
+     * 'asyncReceive()' and returns. When the operation completes, immediately or when the
+     * counterpart operation arrives, the continuation is pushed to the thread pool queue as a new
+     * task. If the queue rejects the task, the continuation is executed in the thread that
+     * completed the operation.
+     *
+     * The values are stored in a ring buffer allocated when the channel is created, so values
+     * sent with 'trySend()' and received with 'tryReceive()' do not cause allocations. The
+     * asynchronous operations allocate the continuation task.
+     *
+     * @tparam T Type of the values. Must be move constructible.
+     */
+    template <typename T>
+    class Channel
+    {
+    public:
+        /**
+         * Called when an 'asyncSend()' completes. The parameter is true if the value was sent and
+         * false if the channel was closed before the value could be sent.
+         */
+        using SendCallback = MoveOnlyFunction<void( bool sent )>;
+
+        /**
+         * Called when an 'asyncReceive()' completes. The parameter is std::nullopt if the channel
+         * was closed and all the values had been received.
+         */
+        using ReceiveCallback = MoveOnlyFunction<void( std::optional<T> value )>;
+
+        /**
+         * @brief Creates a channel.
+         * @param threadPool The thread pool that executes the parked continuations.
+         * @param capacity Number of values the channel can hold. With capacity 0 a sender waits
+         * until a receiver takes the value.
+         */
+        Channel( ThreadPool& threadPool, size_t capacity );
+
+        /**
+         * @brief Destroys the channel. Parked continuations are destroyed without calling them,
+         * so call 'close()' first if they must be notified.
+         */
+        ~Channel();
+
+        Channel( const Channel& ) = delete;
+        Channel& operator=( const Channel& ) = delete;
+        Channel( Channel&& ) = delete;
+        Channel& operator=( Channel&& ) = delete;
+
+    public:
+        /**
+         * @brief Sends the value if it can be done without waiting.
+         * @param value The value to send. Moved from only if the function returns true.
+         * @return True if the value was sent. False if the channel is full or closed.
+         */
+        bool trySend( T&& value );
+
+        /**
+         * @brief Receives a value if one is available.
+         * @return The received value or std::nullopt if the channel is empty.
+         */
+        std::optional<T> tryReceive();
+
+        /**
+         * @brief Sends the value or parks it until there is room for it.
+         *
+         * If the value can be sent immediately, the callback is pushed to the thread pool right
+         * away. Otherwise it is pushed when a receiver makes room for the value or when the
+         * channel gets closed. The callback is never called before this function returns,
+         * unless the thread pool queue rejects it.
+         * @param value The value to send. Dropped if the channel gets closed.
+         * @param onSent Callback to call when the send completes. May be empty.
+         */
+        void asyncSend( T value, SendCallback onSent );
+
+        /**
+         * @brief Receives a value or parks the callback until a value arrives.
+         *
+         * If a value is available, the callback is pushed to the thread pool right away.
+         * Otherwise it is pushed when a sender provides a value or when the channel gets closed.
+         * Because the callback is not called in the calling thread, a consumer that calls
+         * 'asyncReceive()' again from the callback does not grow the stack.
+         * @param onReceive Callback that gets the value.
+         */
+        void asyncReceive( ReceiveCallback onReceive );
+
+        /**
+         * @brief Closes the channel. Further sends fail. The values already in the channel can
+         * still be received. The parked senders are notified with false and, if the channel is
+         * empty, the parked receivers with std::nullopt.
+         */
+        void close();
+
+        /**
+         * @brief Checks if the channel has been closed.
+         * @return True if 'close()' has been called.
+         */
+        bool isClosed() const;
+
+        /**
+         * @brief Returns the number of values in the channel, not counting parked senders.
+         * @return Number of values.
+         */
+        size_t getSize() const;
+
+        /**
+         * @brief Returns the capacity of the channel.
+         * @return Number of values the channel can hold.
+         */
+        size_t getCapacity() const;
+
+    private:
+        struct ParkedSender
+        {
+            T value;
+            SendCallback onSent;
+        };
+
+        /**
+         * Continuation of a parked 'asyncSend()'.
+         */
+        class SendCompletedTask : public TaskBase
+        {
+        public:
+            SendCompletedTask( uint64_t taskId, SendCallback onSent, bool sent ) :
+                TaskBase( taskId ),
+                mOnSent( std::move( onSent ) ),
+                mSent( sent )
+            {
+            }
+
+            void execute() override
+            {
+                mOnSent( mSent );
+            }
+
+        private:
+            SendCallback mOnSent;
+            bool mSent;
+        };
+
+        /**
+         * Continuation of a parked 'asyncReceive()'.
+         */
+        class ReceiveCompletedTask : public TaskBase
+        {
+        public:
+            ReceiveCompletedTask( uint64_t taskId, ReceiveCallback onReceive, std::optional<T> value ) :
+                TaskBase( taskId ),
+                mOnReceive( std::move( onReceive ) ),
+                mValue( std::move( value ) )
+            {
+            }
+
+            void execute() override
+            {
+                mOnReceive( std::move( mValue ) );
+            }
+
+        private:
+            ReceiveCallback mOnReceive;
+            std::optional<T> mValue;
+        };
+
+    private:
+        /**
+         * Takes a value if one is available. If a parked sender was woken up, its continuation
+         * is returned in 'wokenSender'. Must be called with the mutex locked.
+         */
+        std::optional<T> takeValue( std::unique_ptr<TaskBase>& wokenSender );
+
+        /**
+         * Gives the value to a parked receiver or stores it to the buffer. The woken receiver is
+         * returned in 'wokenReceiver'. Returns false if there is no room. Must be called with the
+         * mutex locked.
+         */
+        bool putValue( T& value, std::unique_ptr<TaskBase>& wokenReceiver );
+
+        /**
+         * Pushes the continuation to the thread pool or executes it if the queue is full. An
+         * exception from a continuation executed here is passed to its 'handleError()'.
+         */
+        void dispatch( std::unique_ptr<TaskBase> continuation );
+
+    private:
+        ThreadPool& mThreadPool;
+        size_t mCapacity;
+        std::vector<std::optional<T>> mBuffer;
+        size_t mHead{ 0 };
+        size_t mSize{ 0 };
+        bool mClosed{ false };
+        std::deque<ParkedSender> mParkedSenders;
+        std::deque<ReceiveCallback> mParkedReceivers;
+        mutable std::mutex mMutex;
+    };
+
+    template <typename T>
+    Channel<T>::Channel( ThreadPool& threadPool, size_t capacity ) :
+        mThreadPool( threadPool ),
+        mCapacity( capacity ),
+        mBuffer( capacity )
+    {
+    }
+
+    template <typename T>
+    Channel<T>::~Channel()
+    {
+    }
+
+    template <typename T>
+    bool Channel<T>::trySend( T&& value )
+    {
+        std::unique_ptr<TaskBase> wokenReceiver;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            if( mClosed || !putValue( value, wokenReceiver ) )
+            {
+                return false;
+            }
+        }
+        dispatch( std::move( wokenReceiver ) );
+        return true;
+    }
+
+    template <typename T>
+    std::optional<T> Channel<T>::tryReceive()
+    {
+        std::unique_ptr<TaskBase> wokenSender;
+        std::optional<T> value;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            value = takeValue( wokenSender );
+        }
+        dispatch( std::move( wokenSender ) );
+        return value;
+    }
+
+    template <typename T>
+    void Channel<T>::asyncSend( T value, SendCallback onSent )
+    {
+        std::unique_ptr<TaskBase> wokenReceiver;
+        bool sent = false;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            if( !mClosed )
+            {
+                sent = putValue( value, wokenReceiver );
+                if( !sent )
+                {
+                    mParkedSenders.push_back( ParkedSender{ std::move( value ), std::move( onSent ) } );
+                    return;
+                }
+            }
+        }
+        dispatch( std::move( wokenReceiver ) );
+        if( onSent )
+        {
+            dispatch( std::make_unique<SendCompletedTask>( mThreadPool.generateId(), std::move( onSent ), sent ) );
+        }
+    }
+
+    template <typename T>
+    void Channel<T>::asyncReceive( ReceiveCallback onReceive )
+    {
+        std::unique_ptr<TaskBase> wokenSender;
+        std::optional<T> value;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            value = takeValue( wokenSender );
+            if( !value.has_value() && !mClosed )
+            {
+                mParkedReceivers.push_back( std::move( onReceive ) );
+                return;
+            }
+        }
+        dispatch( std::move( wokenSender ) );
+        dispatch( std::make_unique<ReceiveCompletedTask>( mThreadPool.generateId(), std::move( onReceive ),
+                                                          std::move( value ) ) );
+    }
+
+    template <typename T>
+    void Channel<T>::close()
+    {
+        std::deque<ParkedSender> parkedSenders;
+        std::deque<ReceiveCallback> parkedReceivers;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mClosed = true;
+            parkedSenders.swap( mParkedSenders );
+            // Receivers are parked only when there are no values to receive.
+            parkedReceivers.swap( mParkedReceivers );
+        }
+        for( auto& sender : parkedSenders )
+        {
+            if( sender.onSent )
+            {
+                dispatch( std::make_unique<SendCompletedTask>( mThreadPool.generateId(),
+                                                               std::move( sender.onSent ), false ) );
+            }
+        }
+        for( auto& receiver : parkedReceivers )
+        {
+            dispatch( std::make_unique<ReceiveCompletedTask>( mThreadPool.generateId(), std::move( receiver ),
+                                                              std::nullopt ) );
+        }
+    }
+
+    template <typename T>
+    bool Channel<T>::isClosed() const
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        return mClosed;
+    }
+
+    template <typename T>
+    size_t Channel<T>::getSize() const
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        return mSize;
+    }
+
+    template <typename T>
+    size_t Channel<T>::getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    template <typename T>
+    std::optional<T> Channel<T>::takeValue( std::unique_ptr<TaskBase>& wokenSender )
+    {
+        std::optional<T> value;
+        if( mSize > 0 )
+        {
+            value = std::move( mBuffer[ mHead ] );
+            mBuffer[ mHead ].reset();
+            mHead = ( mHead + 1 ) % mCapacity;
+            --mSize;
+        }
+        if( mParkedSenders.empty() )
+        {
+            return value;
+        }
+
+        // Move the value of the first parked sender to the freed slot, or straight to the
+        // receiver when the channel has no buffer.
+        ParkedSender& sender = mParkedSenders.front();
+        if( value.has_value() )
+        {
+            mBuffer[ ( mHead + mSize ) % mCapacity ].emplace( std::move( sender.value ) );
+            ++mSize;
+        }
+        else
+        {
+            value.emplace( std::move( sender.value ) );
+        }
+        if( sender.onSent )
+        {
+            wokenSender = std::make_unique<SendCompletedTask>( mThreadPool.generateId(), std::move( sender.onSent ),
+                                                               true );
+        }
+        mParkedSenders.pop_front();
+        return value;
+    }
+
+    template <typename T>
+    bool Channel<T>::putValue( T& value, std::unique_ptr<TaskBase>& wokenReceiver )
+    {
+        if( !mParkedReceivers.empty() )
+        {
+            wokenReceiver = std::make_unique<ReceiveCompletedTask>(
+                mThreadPool.generateId(), std::move( mParkedReceivers.front() ), std::move( value ) );
+            mParkedReceivers.pop_front();
+            return true;
+        }
+        if( mSize == mCapacity )
+        {
+            return false;
+        }
+        mBuffer[ ( mHead + mSize ) % mCapacity ].emplace( std::move( value ) );
+        ++mSize;
+        return true;
+    }
+
+    template <typename T>
+    void Channel<T>::dispatch( std::unique_ptr<TaskBase> continuation )
+    {
+        if( !continuation )
+        {
+            return;
+        }
+        continuation = mThreadPool.tryPushToQueue( std::move( continuation ) );
+        if( !continuation )
+        {
+            return;
+        }
+
+        // Execute the continuation in the current thread when the queue cannot take more tasks.
+        // Errors are handled as the worker threads would so they don't escape to the caller.
+        try
+        {
+            continuation->execute();
+        }
+        catch( const std::exception& )
+        {
+            try
+            {
+                continuation->handleError();
+            }
+            catch( const std::exception& )
+            {
+                // Ignore errors from the error handler like the worker threads do.
+            }
+        }
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_CHANNEL_H
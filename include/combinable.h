@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_COMBINABLE_H
+#define THREADPOOLUNIVERSE_COMBINABLE_H
+
+#include "threadpool.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief Combinable holds a private copy of a value for each worker thread of a thread pool.
+     *
+     * Tasks update the copy of the worker thread that executes them by calling 'local()'. This
+     * needs no synchronization because a worker thread executes only one task at a time. The
+     * copies are merged with 'combine()' or visited with 'forEach()' once the tasks have been
+     * completed, for example after 'ThreadPool::waitAllTasks()'.
+     *
+     * The copies are constructed lazily on the first 'local()' call of each thread and they are
+     * padded to separate cache lines so that the workers do not share cache lines when updating
+     * their copies. Threads that are not worker threads of the thread pool get their own copies
+     * too, but accessing them takes a lock.
+     *
+     * @tparam T Type of the value.
+     */
+    template <typename T>
+    class Combinable
+    {
+    public:
+        using Initializer = std::function<T()>;
+
+        /**
+         * @brief Creates a combinable whose copies are value-initialized.
+         * @param threadPool The thread pool whose worker threads use the combinable.
+         */
+        explicit Combinable( ThreadPool& threadPool );
+
+        /**
+         * @brief Creates a combinable whose copies are created by the initializer.
+         * @param threadPool The thread pool whose worker threads use the combinable.
+         * @param initializer Function that returns the initial value of each copy.
+         */
+        Combinable( ThreadPool& threadPool, Initializer initializer );
+
+        Combinable( const Combinable& ) = delete;
+        Combinable& operator=( const Combinable& ) = delete;
+        Combinable( Combinable&& ) = delete;
+        Combinable& operator=( Combinable&& ) = delete;
+
+    public:
+        /**
+         * @brief Returns the copy of the calling thread. Constructs the copy if this is the first
+         * call from this thread.
+         * @return The copy of the calling thread.
+         */
+        T& local();
+
+        /**
+         * @brief Merges all the copies that have been constructed.
+         * @param combineFunction Function that merges two values and returns the result.
+         * @return The merged value. If no copies have been constructed, returns the initial value.
+         */
+        template <typename CombineFunction>
+        T combine( CombineFunction combineFunction );
+
+        /**
+         * @brief Calls the function for each copy that has been constructed.
+         * @param function Function that takes a reference to a copy.
+         */
+        template <typename Function>
+        void forEach( Function function );
+
+        /**
+         * @brief Destroys all the copies. The next 'local()' call constructs them again.
+         */
+        void clear();
+
+    private:
+        static const size_t kCacheLineSize = 64;
+
+        struct alignas( kCacheLineSize ) Slot
+        {
+            std::optional<T> value;
+        };
+
+    private:
+        ThreadPool& mThreadPool;
+        Initializer mInitializer;
+        std::vector<Slot> mWorkerSlots;
+        std::unordered_map<std::thread::id, std::unique_ptr<T>> mOtherThreadValues;
+        std::mutex mOtherThreadsMutex;
+    };
+
+    template <typename T>
+    Combinable<T>::Combinable( ThreadPool& threadPool ) :
+        Combinable( threadPool, []() { return T(); } )
+    {
+    }
+
+    template <typename T>
+    Combinable<T>::Combinable( ThreadPool& threadPool, Initializer initializer ) :
+        mThreadPool( threadPool ),
+        mInitializer( std::move( initializer ) ),
+        mWorkerSlots( threadPool.getNumberOfThreads() )
+    {
+    }
+
+    template <typename T>
+    T& Combinable<T>::local()
+    {
+        auto workerIndex = mThreadPool.getCurrentWorkerIndex();
+        if( workerIndex.has_value() && workerIndex.value() < mWorkerSlots.size() )
+        {
+            Slot& slot = mWorkerSlots[ workerIndex.value() ];
+            if( !slot.value.has_value() )
+            {
+                slot.value.emplace( mInitializer() );
+            }
+            return slot.value.value();
+        }
+
+        std::lock_guard<std::mutex> lock( mOtherThreadsMutex );
+        auto& value = mOtherThreadValues[ std::this_thread::get_id() ];
+        if( !value )
+        {
+            value = std::make_unique<T>( mInitializer() );
+        }
+        return *value;
+    }
+
+    template <typename T>
+    template <typename CombineFunction>
+    T Combinable<T>::combine( CombineFunction combineFunction )
+    {
+        std::optional<T> result;
+        forEach( [&result, &combineFunction]( T& value ) {
+            if( result.has_value() )
+            {
+                result = combineFunction( std::move( result.value() ), value );
+            }
+            else
+            {
+                result = value;
+            }
+        } );
+        return result.has_value() ? std::move( result.value() ) : mInitializer();
+    }
+
+    template <typename T>
+    template <typename Function>
+    void Combinable<T>::forEach( Function function )
+    {
+        for( auto& slot : mWorkerSlots )
+        {
+            if( slot.value.has_value() )
+            {
+                function( slot.value.value() );
+            }
+        }
+        std::lock_guard<std::mutex> lock( mOtherThreadsMutex );
+        for( auto& otherThreadValue : mOtherThreadValues )
+        {
+            function( *otherThreadValue.second );
+        }
+    }
+
+    template <typename T>
+    void Combinable<T>::clear()
+    {
+        for( auto& slot : mWorkerSlots )
+        {
+            slot.value.reset();
+        }
+        std::lock_guard<std::mutex> lock( mOtherThreadsMutex );
+        mOtherThreadValues.clear();
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_COMBINABLE_H
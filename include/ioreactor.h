@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_IOREACTOR_H
+#define THREADPOOLUNIVERSE_IOREACTOR_H
+
+#if defined( __linux__ )
+
+#include "moveonlyfunction.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    class TaskBase;
+    class ThreadPool;
+
+    /**
+     * @brief IoReactor waits for file descriptors on behalf of the tasks and enqueues
+     * continuation tasks to the thread pool when the I/O can proceed.
+     *
+     * This lets the tasks do I/O without blocking a worker thread while waiting. The reactor runs
+     * its own thread that waits for the file descriptors with epoll. Reads and writes are done by
+     * the reactor thread and their results are delivered to callbacks that are executed in the
+     * worker threads of the thread pool.
+     *
+     * The file descriptors are switched to non-blocking mode when they are first used with the
+     * reactor. Regular files cannot be waited with epoll so the operations on them are
+     * completed immediately by the reactor thread. Writing to a pipe or socket whose other end
+     * has been closed completes the write with EPIPE error. If the thread pool queue rejects the
+     * continuation of a completed operation, the continuation is executed in the reactor thread.
+     *
+     * This class is available only in Linux.
+     */
+    class IoReactor
+    {
+    public:
+        /**
+         * @brief The I/O readiness events a task can wait for.
+         */
+        enum class IoEvent
+        {
+            Readable,
+            Writable
+        };
+
+        /**
+         * Called when read operation has completed. The 'data' contains the bytes read. Empty data
+         * with zero error means end of file. The 'error' is the errno value of the failed read.
+         */
+        using ReadCallback = MoveOnlyFunction<void( std::vector<char> data, int error )>;
+
+        /**
+         * Called when write operation has completed. The 'bytesWritten' tells how many bytes were
+         * written before the possible error. The 'error' is the errno value of the failed write.
+         */
+        using WriteCallback = MoveOnlyFunction<void( size_t bytesWritten, int error )>;
+
+        /**
+         * @brief Creates the reactor and starts the reactor thread.
+         * @param threadPool The thread pool where the continuation tasks are pushed to.
+         * @throws std::system_error if the epoll instance cannot be created.
+         */
+        explicit IoReactor( ThreadPool& threadPool );
+
+        /**
+         * @brief Stops the reactor thread. The pending operations are discarded without calling
+         * their continuations.
+         */
+        ~IoReactor();
+
+        IoReactor( const IoReactor& ) = delete;
+        IoReactor& operator=( const IoReactor& ) = delete;
+        IoReactor( IoReactor&& ) = delete;
+        IoReactor& operator=( IoReactor&& ) = delete;
+
+    public:
+        /**
+         * @brief Pushes the continuation task to the thread pool once the file descriptor
+         * becomes readable or writable. The registration is one-shot.
+         * @param fd The file descriptor to wait for.
+         * @param event The event to wait for.
+         * @param continuation The task to push to the thread pool when the event occurs.
+         * @throws std::system_error if the file descriptor cannot be waited for.
+         */
+        void watch( int fd, IoEvent event, std::unique_ptr<TaskBase> continuation );
+
+        /**
+         * @brief Reads up to 'maxBytes' from the file descriptor once it has data available.
+         * @param fd The file descriptor to read from.
+         * @param maxBytes Maximum number of bytes to read.
+         * @param callback Callback executed in the thread pool with the read data.
+         * @throws std::system_error if the file descriptor cannot be waited for.
+         */
+        void submitRead( int fd, size_t maxBytes, ReadCallback callback );
+
+        /**
+         * @brief Writes all the given data to the file descriptor as it becomes writable.
+         * @param fd The file descriptor to write to.
+         * @param data The data to write.
+         * @param callback Callback executed in the thread pool when all data has been written
+         * or the write has failed.
+         * @throws std::system_error if the file descriptor cannot be waited for.
+         */
+        void submitWrite( int fd, std::vector<char> data, WriteCallback callback );
+
+        /**
+         * @brief Cancels all pending operations of the file descriptor. Must be called before
+         * closing a file descriptor that still has pending operations. The callbacks of the
+         * canceled reads and writes are called with ECANCELED error. If the thread pool queue
+         * rejects them, they are called in the calling thread before this function returns. The
+         * continuations of the canceled watches are discarded.
+         * @param fd The file descriptor.
+         */
+        void cancel( int fd );
+
+        /**
+         * @brief Returns the number of operations waiting for their file descriptor.
+         * @return Number of pending operations.
+         */
+        size_t getNumberOfPendingOperations();
+
+    private:
+        struct Operation
+        {
+            std::unique_ptr<TaskBase> continuation;
+            ReadCallback readCallback;
+            WriteCallback writeCallback;
+            size_t maxBytes{ 0 };
+            std::vector<char> data;
+            size_t bytesDone{ 0 };
+        };
+
+        struct FdState
+        {
+            std::deque<Operation> readOperations;
+            std::deque<Operation> writeOperations;
+            uint32_t registeredEvents{ 0 };
+            bool pollable{ true };
+        };
+
+        static void threadFunction( IoReactor* reactor );
+        void threadMain();
+        void addOperation( int fd, IoEvent event, Operation operation );
+        void updateRegistration( int fd, FdState& state );
+        void processFd( int fd, uint32_t events );
+        std::unique_ptr<TaskBase> tryComplete( int fd, IoEvent event, Operation& operation );
+        void deliver( std::unique_ptr<TaskBase> completion );
+        void wakeUp();
+
+    private:
+        ThreadPool& mThreadPool;
+        int mEpollFd{ -1 };
+        int mWakeFd{ -1 };
+        std::atomic_bool mRequestExit;
+        std::unordered_map<int, FdState> mFdStates;
+        std::vector<int> mReadyFds;
+        std::mutex mStateMutex;
+        std::thread mReactorThread;
+    };
+}  // namespace threadpooluniverse
+
+#endif  // __linux__
+
+#endif  // THREADPOOLUNIVERSE_IOREACTOR_H
@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_MOVEONLYFUNCTION_H
+#define THREADPOOLUNIVERSE_MOVEONLYFUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace threadpooluniverse
+{
+    /**
+     * Default size of the inline buffer of MoveOnlyFunction in bytes.
+     */
+    const size_t kDefaultFunctionInlineSize = 64;
+
+    template <typename Signature, size_t InlineSize = kDefaultFunctionInlineSize>
+    class MoveOnlyFunction;
+
+    /**
+     * @brief MoveOnlyFunction is a type-erased callable like 'std::function' but it can hold
+     * callables that cannot be copied, such as lambdas that capture a 'std::unique_ptr'.
+     *
+     * Callables that fit to the inline buffer and can be moved without exceptions are stored
+     * inside the MoveOnlyFunction object, so wrapping a typical lambda does not allocate. Bigger
+     * callables are allocated from the heap.
+     *
+     * @tparam R Return type.
+     * @tparam Args Parameter types.
+     * @tparam InlineSize Size of the inline buffer in bytes.
+     */
+    template <typename R, typename... Args, size_t InlineSize>
+    class MoveOnlyFunction<R( Args... ), InlineSize>
+    {
+    public:
+        /**
+         * @brief Creates an empty function.
+         */
+        MoveOnlyFunction() noexcept;
+
+        /**
+         * @brief Creates an empty function.
+         */
+        MoveOnlyFunction( std::nullptr_t ) noexcept;
+
+        /**
+         * @brief Creates a function that holds the callable. Null function pointers and empty
+         * 'std::function' objects create an empty function.
+         * @param callable The callable to store. Moved or copied into the function.
+         */
+        template <typename F,
+                  typename = std::enable_if_t<!std::is_same<std::decay_t<F>, MoveOnlyFunction>::value &&
+                                              std::is_invocable_r<R, std::decay_t<F>&, Args...>::value>>
+        MoveOnlyFunction( F&& callable );
+
+        MoveOnlyFunction( MoveOnlyFunction&& other ) noexcept;
+        MoveOnlyFunction& operator=( MoveOnlyFunction&& other ) noexcept;
+        MoveOnlyFunction& operator=( std::nullptr_t ) noexcept;
+        ~MoveOnlyFunction();
+
+        MoveOnlyFunction( const MoveOnlyFunction& ) = delete;
+        MoveOnlyFunction& operator=( const MoveOnlyFunction& ) = delete;
+
+    public:
+        /**
+         * @brief Calls the stored callable. The function must not be empty.
+         */
+        R operator()( Args... args );
+
+        /**
+         * @brief Checks if the function holds a callable.
+         */
+        explicit operator bool() const noexcept;
+
+        /**
+         * @brief Checks if the callable is stored in the inline buffer.
+         * @return True if the callable did not need a heap allocation. False for empty functions.
+         */
+        bool isStoredInline() const noexcept;
+
+    private:
+        struct Operations
+        {
+            R ( *invoke )( void* storage, Args&&... args );
+            // Moves the callable to uninitialized storage and destroys the source.
+            void ( *relocate )( void* source, void* destination ) noexcept;
+            void ( *destroy )( void* storage ) noexcept;
+            bool storedInline;
+        };
+
+        template <typename F>
+        static constexpr bool kFitsInline = sizeof( F ) <= InlineSize &&
+                                            alignof( F ) <= alignof( std::max_align_t ) &&
+                                            std::is_nothrow_move_constructible<F>::value;
+
+        template <typename F>
+        struct InlineOperations
+        {
+            static R invoke( void* storage, Args&&... args )
+            {
+                return std::invoke( *static_cast<F*>( storage ), std::forward<Args>( args )... );
+            }
+
+            static void relocate( void* source, void* destination ) noexcept
+            {
+                new( destination ) F( std::move( *static_cast<F*>( source ) ) );
+                static_cast<F*>( source )->~F();
+            }
+
+            static void destroy( void* storage ) noexcept
+            {
+                static_cast<F*>( storage )->~F();
+            }
+
+            static constexpr Operations kOperations{ &invoke, &relocate, &destroy, true };
+        };
+
+        template <typename F>
+        struct HeapOperations
+        {
+            static R invoke( void* storage, Args&&... args )
+            {
+                return std::invoke( **static_cast<F**>( storage ), std::forward<Args>( args )... );
+            }
+
+            static void relocate( void* source, void* destination ) noexcept
+            {
+                *static_cast<F**>( destination ) = *static_cast<F**>( source );
+            }
+
+            static void destroy( void* storage ) noexcept
+            {
+                delete *static_cast<F**>( storage );
+            }
+
+            static constexpr Operations kOperations{ &invoke, &relocate, &destroy, false };
+        };
+
+        template <typename F>
+        static bool isNull( const F& callable );
+
+        void reset() noexcept;
+
+    private:
+        alignas( std::max_align_t ) unsigned char mStorage[ InlineSize < sizeof( void* ) ? sizeof( void* ) : InlineSize ];
+        const Operations* mOperations{ nullptr };
+    };
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>::MoveOnlyFunction() noexcept
+    {
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>::MoveOnlyFunction( std::nullptr_t ) noexcept
+    {
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    template <typename F, typename>
+    MoveOnlyFunction<R( Args... ), InlineSize>::MoveOnlyFunction( F&& callable )
+    {
+        using Callable = std::decay_t<F>;
+        if( isNull( callable ) )
+        {
+            return;
+        }
+        if constexpr( kFitsInline<Callable> )
+        {
+            new( mStorage ) Callable( std::forward<F>( callable ) );
+            mOperations = &InlineOperations<Callable>::kOperations;
+        }
+        else
+        {
+            *reinterpret_cast<Callable**>( mStorage ) = new Callable( std::forward<F>( callable ) );
+            mOperations = &HeapOperations<Callable>::kOperations;
+        }
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>::MoveOnlyFunction( MoveOnlyFunction&& other ) noexcept
+    {
+        if( other.mOperations != nullptr )
+        {
+            other.mOperations->relocate( other.mStorage, mStorage );
+            mOperations = other.mOperations;
+            other.mOperations = nullptr;
+        }
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>& MoveOnlyFunction<R( Args... ), InlineSize>::operator=(
+        MoveOnlyFunction&& other ) noexcept
+    {
+        if( this != &other )
+        {
+            reset();
+            if( other.mOperations != nullptr )
+            {
+                other.mOperations->relocate( other.mStorage, mStorage );
+                mOperations = other.mOperations;
+                other.mOperations = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>& MoveOnlyFunction<R( Args... ), InlineSize>::operator=(
+        std::nullptr_t ) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>::~MoveOnlyFunction()
+    {
+        reset();
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    R MoveOnlyFunction<R( Args... ), InlineSize>::operator()( Args... args )
+    {
+        return mOperations->invoke( mStorage, std::forward<Args>( args )... );
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    MoveOnlyFunction<R( Args... ), InlineSize>::operator bool() const noexcept
+    {
+        return mOperations != nullptr;
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    bool MoveOnlyFunction<R( Args... ), InlineSize>::isStoredInline() const noexcept
+    {
+        return mOperations != nullptr && mOperations->storedInline;
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    template <typename F>
+    bool MoveOnlyFunction<R( Args... ), InlineSize>::isNull( const F& callable )
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr( std::is_pointer<Callable>::value || std::is_member_pointer<Callable>::value )
+        {
+            return callable == nullptr;
+        }
+        else if constexpr( std::is_same<Callable, std::function<R( Args... )>>::value )
+        {
+            return !callable;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    template <typename R, typename... Args, size_t InlineSize>
+    void MoveOnlyFunction<R( Args... ), InlineSize>::reset() noexcept
+    {
+        if( mOperations != nullptr )
+        {
+            mOperations->destroy( mStorage );
+            mOperations = nullptr;
+        }
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_MOVEONLYFUNCTION_H
@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_PARALLELALGORITHMS_H
+#define THREADPOOLUNIVERSE_PARALLELALGORITHMS_H
+
+#include "threadpool.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * Ranges shorter than this are processed with the sequential standard algorithms.
+     */
+    const size_t kParallelAlgorithmCutoff = 16 * 1024;
+
+    /**
+     * @brief Calls the body for every index from zero to 'count - 1' in the worker threads of the
+     * thread pool and in the calling thread.
+     *
+     * The calling thread takes indices too, so the function completes even when all the worker
+     * threads are busy or the processing has not been started. Returns when the body has been
+     * called for every index.
+     *
+     * @param threadPool The thread pool whose worker threads help with the work.
+     * @param count Number of indices.
+     * @param body Function that gets called with each index.
+     * @throws The first exception thrown by the body. The remaining indices are skipped after
+     * an exception.
+     */
+    void parallelFor( ThreadPool& threadPool, size_t count, const std::function<void( size_t index )>& body );
+
+    /**
+     * @brief Sorts the range in parallel. The chunks of the range are sorted with 'std::sort' and
+     * then merged in parallel. Like 'std::sort', the sort is not stable.
+     *
+     * @param threadPool The thread pool whose worker threads help with the sorting.
+     * @param first Beginning of the range.
+     * @param last End of the range.
+     * @param compare The comparison function.
+     * @tparam RandomIt Random access iterator. The value type must be default constructible and
+     * move assignable.
+     */
+    template <typename RandomIt, typename Compare>
+    void parallelSort( ThreadPool& threadPool, RandomIt first, RandomIt last, Compare compare );
+
+    /**
+     * @brief Sorts the range in parallel into ascending order.
+     */
+    template <typename RandomIt>
+    void parallelSort( ThreadPool& threadPool, RandomIt first, RandomIt last );
+
+    /**
+     * @brief Computes the inclusive prefix sums of the range in parallel like 'std::inclusive_scan'.
+     * The operation must be associative. The output range may be the same as the input range.
+     * @return Iterator to the element past the last written element.
+     */
+    template <typename RandomIt, typename OutputIt, typename BinaryOp>
+    OutputIt parallelInclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, BinaryOp operation );
+
+    /**
+     * @brief Computes the inclusive prefix sums of the range in parallel using addition.
+     */
+    template <typename RandomIt, typename OutputIt>
+    OutputIt parallelInclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination );
+
+    /**
+     * @brief Computes the exclusive prefix sums of the range in parallel like 'std::exclusive_scan'.
+     * The operation must be associative. The output range may be the same as the input range.
+     * @return Iterator to the element past the last written element.
+     */
+    template <typename RandomIt, typename OutputIt, typename T, typename BinaryOp>
+    OutputIt parallelExclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, T init, BinaryOp operation );
+
+    /**
+     * @brief Computes the exclusive prefix sums of the range in parallel using addition.
+     */
+    template <typename RandomIt, typename OutputIt, typename T>
+    OutputIt parallelExclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, T init );
+
+    namespace detail
+    {
+        /**
+         * Returns the number of chunks a range of given length is split into.
+         */
+        inline size_t getNumberOfChunks( ThreadPool& threadPool, size_t length )
+        {
+            size_t maxChunks = std::max<size_t>( length / ( kParallelAlgorithmCutoff / 2 ), 1 );
+            return std::min( threadPool.getNumberOfThreads() + 1, maxChunks );
+        }
+
+        /**
+         * Returns the beginning of the chunk when a range is split into chunks of equal size.
+         */
+        inline size_t getChunkBegin( size_t length, size_t numChunks, size_t chunk )
+        {
+            return length / numChunks * chunk + std::min( chunk, length % numChunks );
+        }
+
+        /**
+         * Returns how many elements of the first range are within the first 'diagonal' elements
+         * of the merged output.
+         */
+        template <typename RandomIt, typename Compare>
+        size_t findMergeSplit( RandomIt first1, size_t length1, RandomIt first2, size_t length2,
+                               size_t diagonal, Compare& compare )
+        {
+            size_t low = diagonal > length2 ? diagonal - length2 : 0;
+            size_t high = std::min( diagonal, length1 );
+            while( low < high )
+            {
+                size_t middle = low + ( high - low ) / 2;
+                if( compare( first2[ diagonal - middle - 1 ], first1[ middle ] ) )
+                {
+                    high = middle;
+                }
+                else
+                {
+                    low = middle + 1;
+                }
+            }
+            return low;
+        }
+    }  // namespace detail
+
+    template <typename RandomIt, typename Compare>
+    void parallelSort( ThreadPool& threadPool, RandomIt first, RandomIt last, Compare compare )
+    {
+        using ValueType = typename std::iterator_traits<RandomIt>::value_type;
+        const size_t length = static_cast<size_t>( last - first );
+        const size_t numChunks = detail::getNumberOfChunks( threadPool, length );
+        if( numChunks < 2 )
+        {
+            std::sort( first, last, compare );
+            return;
+        }
+
+        // Sort the chunks.
+        std::vector<size_t> runBounds;
+        for( size_t chunk = 0; chunk <= numChunks; ++chunk )
+        {
+            runBounds.push_back( detail::getChunkBegin( length, numChunks, chunk ) );
+        }
+        parallelFor( threadPool, numChunks, [&]( size_t chunk ) {
+            std::sort( first + runBounds[ chunk ], first + runBounds[ chunk + 1 ], compare );
+        } );
+
+        // Merge the sorted runs pairwise, moving them between the range and the buffer. Each
+        // merge is split to pieces along the merge path so that also the last merges run in
+        // parallel.
+        std::vector<ValueType> buffer( length );
+        bool inBuffer = false;
+        while( runBounds.size() > 2 )
+        {
+            std::vector<size_t> mergedBounds;
+            for( size_t i = 0; i < runBounds.size(); i += 2 )
+            {
+                mergedBounds.push_back( runBounds[ i ] );
+            }
+            if( mergedBounds.back() != length )
+            {
+                mergedBounds.push_back( length );
+            }
+
+            const size_t numMerges = mergedBounds.size() - 1;
+            const size_t piecesPerMerge = ( numChunks + numMerges - 1 ) / numMerges;
+            auto getRun = [&]( auto source, size_t merge, size_t& length1, size_t& length2 ) {
+                size_t begin1 = runBounds[ merge * 2 ];
+                size_t end1 = runBounds[ merge * 2 + 1 ];
+                length1 = end1 - begin1;
+                length2 = mergedBounds[ merge + 1 ] - end1;
+                return source + begin1;
+            };
+
+            // The merges move the elements, so all the merge path splits are searched before
+            // any of the pieces is merged.
+            std::vector<size_t> splits( numMerges * ( piecesPerMerge + 1 ) );
+            auto findSplit = [&]( auto source, size_t index ) {
+                size_t merge = index / ( piecesPerMerge + 1 );
+                size_t length1 = 0;
+                size_t length2 = 0;
+                auto first1 = getRun( source, merge, length1, length2 );
+                size_t diagonal = detail::getChunkBegin( length1 + length2, piecesPerMerge,
+                                                         index % ( piecesPerMerge + 1 ) );
+                splits[ index ] = detail::findMergeSplit( first1, length1, first1 + length1, length2,
+                                                          diagonal, compare );
+            };
+            auto mergePiece = [&]( auto source, auto destination, size_t job ) {
+                size_t merge = job / piecesPerMerge;
+                size_t piece = job % piecesPerMerge;
+                size_t length1 = 0;
+                size_t length2 = 0;
+                auto first1 = getRun( source, merge, length1, length2 );
+                auto first2 = first1 + length1;
+                size_t diagonalBegin = detail::getChunkBegin( length1 + length2, piecesPerMerge, piece );
+                size_t diagonalEnd = detail::getChunkBegin( length1 + length2, piecesPerMerge, piece + 1 );
+                size_t split1Begin = splits[ merge * ( piecesPerMerge + 1 ) + piece ];
+                size_t split1End = splits[ merge * ( piecesPerMerge + 1 ) + piece + 1 ];
+                std::merge( std::make_move_iterator( first1 + split1Begin ),
+                            std::make_move_iterator( first1 + split1End ),
+                            std::make_move_iterator( first2 + ( diagonalBegin - split1Begin ) ),
+                            std::make_move_iterator( first2 + ( diagonalEnd - split1End ) ),
+                            destination + runBounds[ merge * 2 ] + diagonalBegin, compare );
+            };
+            parallelFor( threadPool, splits.size(), [&]( size_t index ) {
+                if( inBuffer )
+                {
+                    findSplit( buffer.begin(), index );
+                }
+                else
+                {
+                    findSplit( first, index );
+                }
+            } );
+            parallelFor( threadPool, numMerges * piecesPerMerge, [&]( size_t job ) {
+                if( inBuffer )
+                {
+                    mergePiece( buffer.begin(), first, job );
+                }
+                else
+                {
+                    mergePiece( first, buffer.begin(), job );
+                }
+            } );
+            inBuffer = !inBuffer;
+            runBounds.swap( mergedBounds );
+        }
+
+        if( inBuffer )
+        {
+            parallelFor( threadPool, numChunks, [&]( size_t chunk ) {
+                size_t begin = detail::getChunkBegin( length, numChunks, chunk );
+                size_t end = detail::getChunkBegin( length, numChunks, chunk + 1 );
+                std::move( buffer.begin() + begin, buffer.begin() + end, first + begin );
+            } );
+        }
+    }
+
+    template <typename RandomIt>
+    void parallelSort( ThreadPool& threadPool, RandomIt first, RandomIt last )
+    {
+        parallelSort( threadPool, first, last, std::less<>() );
+    }
+
+    template <typename RandomIt, typename OutputIt, typename BinaryOp>
+    OutputIt parallelInclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, BinaryOp operation )
+    {
+        using ValueType = typename std::iterator_traits<RandomIt>::value_type;
+        const size_t length = static_cast<size_t>( last - first );
+        const size_t numChunks = detail::getNumberOfChunks( threadPool, length );
+        if( numChunks < 2 )
+        {
+            return std::inclusive_scan( first, last, destination, operation );
+        }
+
+        // Sum up each chunk except the last one. Their sums are the offsets of the next chunks.
+        std::vector<ValueType> offsets( numChunks );
+        parallelFor( threadPool, numChunks - 1, [&]( size_t chunk ) {
+            auto begin = first + detail::getChunkBegin( length, numChunks, chunk );
+            auto end = first + detail::getChunkBegin( length, numChunks, chunk + 1 );
+            offsets[ chunk + 1 ] = std::accumulate( begin + 1, end, *begin, operation );
+        } );
+        for( size_t chunk = 2; chunk < numChunks; ++chunk )
+        {
+            offsets[ chunk ] = operation( offsets[ chunk - 1 ], offsets[ chunk ] );
+        }
+
+        parallelFor( threadPool, numChunks, [&]( size_t chunk ) {
+            size_t begin = detail::getChunkBegin( length, numChunks, chunk );
+            size_t end = detail::getChunkBegin( length, numChunks, chunk + 1 );
+            if( chunk == 0 )
+            {
+                std::inclusive_scan( first + begin, first + end, destination + begin, operation );
+            }
+            else
+            {
+                std::inclusive_scan( first + begin, first + end, destination + begin, operation,
+                                     offsets[ chunk ] );
+            }
+        } );
+        return destination + length;
+    }
+
+    template <typename RandomIt, typename OutputIt>
+    OutputIt parallelInclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination )
+    {
+        return parallelInclusiveScan( threadPool, first, last, destination, std::plus<>() );
+    }
+
+    template <typename RandomIt, typename OutputIt, typename T, typename BinaryOp>
+    OutputIt parallelExclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, T init, BinaryOp operation )
+    {
+        const size_t length = static_cast<size_t>( last - first );
+        const size_t numChunks = detail::getNumberOfChunks( threadPool, length );
+        if( numChunks < 2 )
+        {
+            return std::exclusive_scan( first, last, destination, init, operation );
+        }
+
+        // Sum up each chunk except the last one. The offset of a chunk is the initial value
+        // combined with the sums of the previous chunks.
+        std::vector<T> offsets( numChunks, init );
+        parallelFor( threadPool, numChunks - 1, [&]( size_t chunk ) {
+            auto begin = first + detail::getChunkBegin( length, numChunks, chunk );
+            auto end = first + detail::getChunkBegin( length, numChunks, chunk + 1 );
+            offsets[ chunk + 1 ] = std::accumulate( begin + 1, end, T( *begin ), operation );
+        } );
+        for( size_t chunk = 1; chunk < numChunks; ++chunk )
+        {
+            offsets[ chunk ] = operation( offsets[ chunk - 1 ], offsets[ chunk ] );
+        }
+
+        parallelFor( threadPool, numChunks, [&]( size_t chunk ) {
+            size_t begin = detail::getChunkBegin( length, numChunks, chunk );
+            size_t end = detail::getChunkBegin( length, numChunks, chunk + 1 );
+            std::exclusive_scan( first + begin, first + end, destination + begin, offsets[ chunk ],
+                                 operation );
+        } );
+        return destination + length;
+    }
+
+    template <typename RandomIt, typename OutputIt, typename T>
+    OutputIt parallelExclusiveScan( ThreadPool& threadPool, RandomIt first, RandomIt last,
+                                    OutputIt destination, T init )
+    {
+        return parallelExclusiveScan( threadPool, first, last, destination, std::move( init ),
+                                      std::plus<>() );
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_PARALLELALGORITHMS_H
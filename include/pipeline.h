@@ -0,0 +1,421 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_PIPELINE_H
+#define THREADPOOLUNIVERSE_PIPELINE_H
+
+#include "callbacktask.h"
+#include "taskbase.h"
+#include "threadpool.h"
+#include "threadpoolexceptions.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief Pipeline processes a stream of items through a sequence of stages in thread pool.
+     *
+     * The items are stored in a fixed number of tokens that are allocated when the pipeline is
+     * created. The source function fills a free token and the token then travels through the
+     * stages until it is released after the last stage. Because the number of tokens is bounded
+     * the memory usage stays flat regardless of the length of the stream, and the items are
+     * never copied or re-allocated when handed from a stage to another.
+     *
+     * The thread pool must be processing tasks when 'run()' is called. The 'run()' should not be
+     * called from a worker thread of the same thread pool.
+     *
+     * @tparam T Type of the item. Must be default constructible. Token items are reused so the
+     * source function should overwrite the whole item.
+     */
+    template <typename T>
+    class Pipeline
+    {
+    public:
+        /**
+         * @brief Defines how the items are processed by a stage.
+         */
+        enum class StageMode
+        {
+            /** One item at a time, in the order the source produced them. */
+            SerialInOrder,
+            /** One item at a time, in any order. */
+            SerialAnyOrder,
+            /** Several items concurrently. */
+            Parallel
+        };
+
+        /** Processes the item in place. */
+        using StageFunction = std::function<void( T& item )>;
+
+        /** Fills the next item. Returns false when there are no more items. */
+        using SourceFunction = std::function<bool( T& item )>;
+
+        /**
+         * @brief Creates a pipeline.
+         * @param threadPool The thread pool that executes the stages.
+         * @param maxTokens Maximum number of items in flight at the same time.
+         */
+        Pipeline( ThreadPool& threadPool, size_t maxTokens );
+
+        Pipeline( const Pipeline& ) = delete;
+        Pipeline& operator=( const Pipeline& ) = delete;
+        Pipeline( Pipeline&& ) = delete;
+        Pipeline& operator=( Pipeline&& ) = delete;
+
+    public:
+        /**
+         * @brief Appends a stage to the end of the pipeline.
+         * @param mode How the items are processed by the stage.
+         * @param function The function that processes the items.
+         */
+        void addStage( StageMode mode, StageFunction function );
+
+        /**
+         * @brief Runs the pipeline until the source runs out of items and all the items have
+         * passed through the stages. The source function is called from the calling thread.
+         * @param source The function that produces the items.
+         * @throws The first exception thrown by the source or a stage. Once an exception has been
+         * thrown no new items are produced and the remaining stages of the items in flight are
+         * skipped. If a task of a stage gets removed from the thread pool queue, for example by
+         * 'ThreadPool::clearQueue()', the run fails the same way with TaskDroppedException.
+         */
+        void run( SourceFunction source );
+
+    private:
+        struct Token
+        {
+            T item;
+            uint64_t sequence{ 0 };
+        };
+
+        /**
+         * Executes a piece of work of a stage. If the task is destroyed without executing it,
+         * the run fails and the work is completed with the stages skipped, so that 'run()' does
+         * not wait for its token forever.
+         */
+        class StageTask : public TaskBase
+        {
+        public:
+            StageTask( uint64_t taskId, Pipeline& pipeline, CallbackTask::ExecuteCallback work ) :
+                TaskBase( taskId ),
+                mPipeline( pipeline ),
+                mWork( std::move( work ) )
+            {
+            }
+
+            ~StageTask() override
+            {
+                if( mWork )
+                {
+                    mPipeline.recordError( std::make_exception_ptr(
+                        TaskDroppedException( "Pipeline stage task was removed from the queue." ) ) );
+                    runWork();
+                }
+            }
+
+            void execute() override
+            {
+                runWork();
+            }
+
+        private:
+            void runWork()
+            {
+                auto work = std::move( mWork );
+                mWork = nullptr;
+                work();
+                mPipeline.finishWork();
+            }
+
+            Pipeline& mPipeline;
+            CallbackTask::ExecuteCallback mWork;
+        };
+
+        struct Stage
+        {
+            StageMode mode;
+            StageFunction function;
+            std::mutex mutex;
+            bool busy{ false };
+            uint64_t nextSequence{ 0 };
+            std::map<uint64_t, size_t> inOrderTokens;
+            std::deque<size_t> anyOrderTokens;
+        };
+
+        void dispatch( size_t stageIndex, size_t tokenIndex );
+        void runSerialStage( size_t stageIndex, size_t tokenIndex );
+        void runStageFunction( size_t stageIndex, size_t tokenIndex );
+        std::optional<size_t> takeNextToken( Stage& stage );
+        void releaseToken( size_t tokenIndex );
+        void recordError( std::exception_ptr error );
+        void submit( CallbackTask::ExecuteCallback work );
+        void finishWork();
+
+    private:
+        ThreadPool& mThreadPool;
+        std::vector<Token> mTokens;
+        std::vector<std::unique_ptr<Stage>> mStages;
+        std::vector<size_t> mFreeTokens;
+        std::mutex mMutex;
+        std::condition_variable mTokenReleasedCV;
+        size_t mNumberOfActiveWorks{ 0 };
+        std::exception_ptr mError;
+        std::atomic_bool mFailed;
+    };
+
+    template <typename T>
+    Pipeline<T>::Pipeline( ThreadPool& threadPool, size_t maxTokens ) :
+        mThreadPool( threadPool ),
+        mTokens( maxTokens > 0 ? maxTokens : 1 ),
+        mFailed( false )
+    {
+    }
+
+    template <typename T>
+    void Pipeline<T>::addStage( StageMode mode, StageFunction function )
+    {
+        auto stage = std::make_unique<Stage>();
+        stage->mode = mode;
+        stage->function = std::move( function );
+        mStages.push_back( std::move( stage ) );
+    }
+
+    template <typename T>
+    void Pipeline<T>::run( SourceFunction source )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mFreeTokens.clear();
+            for( size_t i = mTokens.size(); i > 0; --i )
+            {
+                mFreeTokens.push_back( i - 1 );
+            }
+            mError = nullptr;
+            mFailed.store( false );
+        }
+        for( auto& stage : mStages )
+        {
+            stage->nextSequence = 0;
+        }
+
+        uint64_t sequence = 0;
+        while( true )
+        {
+            size_t tokenIndex = 0;
+            {
+                std::unique_lock<std::mutex> lock( mMutex );
+                mTokenReleasedCV.wait( lock, [this]() { return !mFreeTokens.empty(); } );
+                tokenIndex = mFreeTokens.back();
+                mFreeTokens.pop_back();
+            }
+
+            bool hasItem = false;
+            if( !mFailed.load() )
+            {
+                try
+                {
+                    hasItem = source( mTokens[ tokenIndex ].item );
+                }
+                catch( ... )
+                {
+                    recordError( std::current_exception() );
+                }
+            }
+            if( !hasItem )
+            {
+                releaseToken( tokenIndex );
+                break;
+            }
+            mTokens[ tokenIndex ].sequence = sequence++;
+            dispatch( 0, tokenIndex );
+        }
+
+        // Wait until all the tokens have made their way through the pipeline and the tasks
+        // executing the stages have finished.
+        std::unique_lock<std::mutex> lock( mMutex );
+        mTokenReleasedCV.wait( lock, [this]() {
+            return mFreeTokens.size() == mTokens.size() && mNumberOfActiveWorks == 0;
+        } );
+        if( mError )
+        {
+            std::rethrow_exception( mError );
+        }
+    }
+
+    template <typename T>
+    void Pipeline<T>::dispatch( size_t stageIndex, size_t tokenIndex )
+    {
+        if( stageIndex == mStages.size() )
+        {
+            releaseToken( tokenIndex );
+            return;
+        }
+
+        Stage& stage = *mStages[ stageIndex ];
+        if( stage.mode == StageMode::Parallel )
+        {
+            submit( [this, stageIndex, tokenIndex]() {
+                runStageFunction( stageIndex, tokenIndex );
+                dispatch( stageIndex + 1, tokenIndex );
+            } );
+            return;
+        }
+
+        // Serial stages buffer the token until the stage is free and the token is next in turn.
+        std::optional<size_t> nextToken;
+        {
+            std::lock_guard<std::mutex> lock( stage.mutex );
+            if( stage.mode == StageMode::SerialInOrder )
+            {
+                stage.inOrderTokens.emplace( mTokens[ tokenIndex ].sequence, tokenIndex );
+            }
+            else
+            {
+                stage.anyOrderTokens.push_back( tokenIndex );
+            }
+            if( stage.busy )
+            {
+                return;
+            }
+            nextToken = takeNextToken( stage );
+            if( !nextToken.has_value() )
+            {
+                return;
+            }
+            stage.busy = true;
+        }
+        size_t serialTokenIndex = nextToken.value();
+        submit( [this, stageIndex, serialTokenIndex]() { runSerialStage( stageIndex, serialTokenIndex ); } );
+    }
+
+    template <typename T>
+    void Pipeline<T>::runSerialStage( size_t stageIndex, size_t tokenIndex )
+    {
+        Stage& stage = *mStages[ stageIndex ];
+        while( true )
+        {
+            runStageFunction( stageIndex, tokenIndex );
+            dispatch( stageIndex + 1, tokenIndex );
+
+            std::lock_guard<std::mutex> lock( stage.mutex );
+            auto nextToken = takeNextToken( stage );
+            if( !nextToken.has_value() )
+            {
+                stage.busy = false;
+                return;
+            }
+            tokenIndex = nextToken.value();
+        }
+    }
+
+    template <typename T>
+    void Pipeline<T>::runStageFunction( size_t stageIndex, size_t tokenIndex )
+    {
+        if( mFailed.load() )
+        {
+            return;
+        }
+        try
+        {
+            mStages[ stageIndex ]->function( mTokens[ tokenIndex ].item );
+        }
+        catch( ... )
+        {
+            recordError( std::current_exception() );
+        }
+    }
+
+    template <typename T>
+    std::optional<size_t> Pipeline<T>::takeNextToken( Stage& stage )
+    {
+        if( stage.mode == StageMode::SerialInOrder )
+        {
+            auto it = stage.inOrderTokens.begin();
+            if( it == stage.inOrderTokens.end() || it->first != stage.nextSequence )
+            {
+                return std::nullopt;
+            }
+            size_t tokenIndex = it->second;
+            stage.inOrderTokens.erase( it );
+            ++stage.nextSequence;
+            return tokenIndex;
+        }
+
+        if( stage.anyOrderTokens.empty() )
+        {
+            return std::nullopt;
+        }
+        size_t tokenIndex = stage.anyOrderTokens.front();
+        stage.anyOrderTokens.pop_front();
+        return tokenIndex;
+    }
+
+    template <typename T>
+    void Pipeline<T>::releaseToken( size_t tokenIndex )
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mFreeTokens.push_back( tokenIndex );
+        mTokenReleasedCV.notify_all();
+    }
+
+    template <typename T>
+    void Pipeline<T>::recordError( std::exception_ptr error )
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        if( !mError )
+        {
+            mError = error;
+        }
+        mFailed.store( true );
+    }
+
+    template <typename T>
+    void Pipeline<T>::submit( CallbackTask::ExecuteCallback work )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            ++mNumberOfActiveWorks;
+        }
+        if( mFailed.load() )
+        {
+            // The stage functions are skipped after a failure so the token only needs to be
+            // passed on. This avoids using the thread pool when a dropped task is completing
+            // its work from its destructor, possibly under the queue lock.
+            work();
+            finishWork();
+            return;
+        }
+        auto rejectedTask = mThreadPool.tryPushToQueue(
+            std::make_unique<StageTask>( mThreadPool.generateId(), *this, std::move( work ) ) );
+        if( rejectedTask )
+        {
+            // Execute the stage in the current thread when the queue cannot take more tasks.
+            rejectedTask->execute();
+        }
+    }
+
+    template <typename T>
+    void Pipeline<T>::finishWork()
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        --mNumberOfActiveWorks;
+        mTokenReleasedCV.notify_all();
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_PIPELINE_H
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_SCRATCHARENA_H
+#define THREADPOOLUNIVERSE_SCRATCHARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief ScratchArena is a bump allocator for temporary memory of the tasks.
+     *
+     * Each worker thread owns a scratch arena that the running task gets with
+     * 'ThreadPool::getCurrentScratchArena()'. Allocations just advance a pointer inside a memory
+     * block and the memory is released all at once by 'reset()'. The blocks are kept over the
+     * resets so after the first few tasks the scratch memory of a worker thread does not cause
+     * any heap allocations. If the blocks have grown beyond the retention limit, e.g. because of
+     * one exceptionally big task, 'reset()' frees them instead.
+     *
+     * The arena does not call destructors of the objects allocated from it.
+     */
+    class ScratchArena
+    {
+    public:
+        /**
+         * @brief Creates an arena. No memory is allocated before the first allocation.
+         * @param blockSize Minimum size of the memory blocks the arena allocates.
+         * @param maxRetainedCapacity Maximum number of bytes kept over a reset.
+         */
+        explicit ScratchArena( size_t blockSize = 64 * 1024, size_t maxRetainedCapacity = 16 * 1024 * 1024 );
+        ~ScratchArena();
+
+        ScratchArena( const ScratchArena& ) = delete;
+        ScratchArena& operator=( const ScratchArena& ) = delete;
+        ScratchArena( ScratchArena&& ) = delete;
+        ScratchArena& operator=( ScratchArena&& ) = delete;
+
+    public:
+        /**
+         * @brief Allocates memory from the arena.
+         * @param size Number of bytes to allocate.
+         * @param alignment Alignment of the memory. Must be a power of two.
+         * @return Pointer to the allocated memory. Valid until the next 'reset()'.
+         * @throws std::bad_alloc if the memory cannot be allocated.
+         */
+        void* allocate( size_t size, size_t alignment = alignof( std::max_align_t ) );
+
+        /**
+         * @brief Allocates an array of value-initialized objects from the arena.
+         * @param count Number of objects.
+         * @return Pointer to the first object. Valid until the next 'reset()'.
+         * @throws std::bad_array_new_length if the size of the array overflows.
+         */
+        template <typename T>
+        T* allocateArray( size_t count );
+
+        /**
+         * @brief Releases all the allocations. The memory blocks are kept for reuse. If more than
+         * one block was needed, they are replaced with one block big enough for all of them. If
+         * the blocks exceed the maximum retained capacity, they are freed.
+         */
+        void reset();
+
+        /**
+         * @brief Returns the number of bytes allocated since the last reset.
+         * @return Number of allocated bytes including the alignment padding.
+         */
+        size_t getBytesAllocated() const;
+
+        /**
+         * @brief Returns the total size of the memory blocks owned by the arena.
+         * @return Capacity in bytes.
+         */
+        size_t getCapacity() const;
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<unsigned char[]> data;
+            size_t size{ 0 };
+        };
+
+    private:
+        size_t mBlockSize;
+        size_t mMaxRetainedCapacity;
+        std::vector<Block> mBlocks;
+        size_t mCurrentBlock{ 0 };
+        size_t mCurrentOffset{ 0 };
+        size_t mBytesAllocated{ 0 };
+    };
+
+    template <typename T>
+    T* ScratchArena::allocateArray( size_t count )
+    {
+        static_assert( std::is_trivially_destructible<T>::value,
+                       "ScratchArena does not call destructors." );
+        if( count > SIZE_MAX / sizeof( T ) )
+        {
+            throw std::bad_array_new_length();
+        }
+        T* objects = static_cast<T*>( allocate( sizeof( T ) * count, alignof( T ) ) );
+        for( size_t i = 0; i < count; ++i )
+        {
+            new( objects + i ) T();
+        }
+        return objects;
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_SCRATCHARENA_H
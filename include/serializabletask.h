@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_SERIALIZABLETASK_H
+#define THREADPOOLUNIVERSE_SERIALIZABLETASK_H
+
+#include "taskbase.h"
+
+#include <vector>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief Base class of the tasks that can be written to the spill file of the thread pool.
+     *
+     * When the overflow spill of the thread pool is enabled and the queue is above its high-water
+     * mark, the thread pool serializes the pushed serializable tasks to the spill file and
+     * destroys them. When the queue drains, the tasks are recreated by the deserializer given in
+     * 'ThreadPool::SpillSettings'. The task ID and the queueing time are restored by the
+     * thread pool, so they need not be serialized. Tasks that have a deadline are never spilled.
+     */
+    class SerializableTask : public TaskBase
+    {
+    public:
+        /**
+         * @brief Constructs a task with a unique ID.
+         * @param taskId Unique ID for the task.
+         */
+        explicit SerializableTask( uint64_t taskId );
+        virtual ~SerializableTask();
+
+        /**
+         * @brief Appends the state that is needed to recreate the task to the buffer.
+         * @param buffer The buffer to append the data to.
+         */
+        virtual void serialize( std::vector<char>& buffer ) const = 0;
+    };
+}
+
+#endif
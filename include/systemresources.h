@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_SYSTEMRESOURCES_H
+#define THREADPOOLUNIVERSE_SYSTEMRESOURCES_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief SystemResources tells how many CPUs the process can actually use.
+     *
+     * 'std::thread::hardware_concurrency()' returns the number of CPUs of the host. In a container
+     * the process is often limited to a fraction of them by a cgroup CPU quota, and a pool sized
+     * by the host CPU count gets throttled. SystemResources reads the quota of the cgroup v1 or
+     * v2 hierarchy the process belongs to and the CPU affinity mask of the process. On other
+     * platforms than Linux only the hardware concurrency is used.
+     */
+    class SystemResources
+    {
+    public:
+        /**
+         * @brief Creates an object that reads the cgroup files from the given locations. Tests
+         * can point these to a directory with fake cgroup files.
+         * @param cgroupRoot Directory where the cgroup file systems are mounted.
+         * @param procSelfCgroup File that lists the cgroups of the process.
+         */
+        explicit SystemResources( std::string cgroupRoot = "/sys/fs/cgroup",
+                                  std::string procSelfCgroup = "/proc/self/cgroup" );
+
+    public:
+        /**
+         * @brief Returns the CPU quota of the cgroups of the process. If the cgroup and its
+         * parents have several quotas, the smallest one is returned.
+         * @return Number of CPUs the quota allows, for example 1.5. std::nullopt if there is no
+         * quota or it cannot be read.
+         */
+        std::optional<double> getCpuQuota() const;
+
+        /**
+         * @brief Returns the number of CPUs in the affinity mask of the process.
+         * @return Number of CPUs the process is allowed to run on. At least 1.
+         */
+        size_t getNumberOfAffinityCpus() const;
+
+        /**
+         * @brief Returns the number of CPUs the process can use. This is the CPU quota rounded up,
+         * limited by the affinity mask.
+         * @return Number of usable CPUs. At least 1.
+         */
+        size_t getNumberOfAvailableCpus() const;
+
+    private:
+        /**
+         * Reads the cgroup v2 'cpu.max' file of the directory.
+         */
+        std::optional<double> readCgroupV2Quota( const std::string& directory ) const;
+
+        /**
+         * Reads the cgroup v1 'cpu.cfs_quota_us' and 'cpu.cfs_period_us' files of the directory.
+         */
+        std::optional<double> readCgroupV1Quota( const std::string& directory ) const;
+
+    private:
+        std::string mCgroupRoot;
+        std::string mProcSelfCgroup;
+    };
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_SYSTEMRESOURCES_H
@@ -9,16 +9,22 @@
 #define THREADPOOLUNIVERSE_TASKBASE_H
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <optional>
 
 namespace threadpooluniverse
 {
+    class ThreadPool;
+
     /**
      * @brief Base class of all the tasks executed by the thread pool.
      */
     class TaskBase
     {
     public:
+        using Clock = std::chrono::steady_clock;
+
         /**
          * @brief Constructs a task with a unique ID.
          * @param taskId Unique ID for the task.
@@ -51,6 +57,30 @@ namespace threadpooluniverse
          */
         bool isCanceled() const;
 
+        /**
+         * @brief Sets the deadline of the task.
+         *
+         * The deadline must be set before the task is pushed to the thread pool queue. The thread
+         * pool uses the deadline when earliest-deadline-first scheduling or dropping of expired
+         * tasks has been enabled.
+         * @param deadline The point of time after which the result of the task is no longer
+         * useful. Pass std::nullopt to remove the deadline.
+         */
+        void setDeadline( std::optional<Clock::time_point> deadline );
+
+        /**
+         * @brief Gets the deadline of the task.
+         * @return The deadline or std::nullopt if the task has no deadline.
+         */
+        std::optional<Clock::time_point> getDeadline() const;
+
+        /**
+         * @brief Checks if the deadline of the task has passed.
+         * @param now The current time.
+         * @return True if task has a deadline and it is earlier than 'now'.
+         */
+        bool isExpired( Clock::time_point now ) const;
+
         /**
          * @brief Does the actual work of the task.
          *
@@ -68,9 +98,25 @@ namespace threadpooluniverse
          */
         virtual void handleError();
 
+        /**
+         * @brief Called instead of 'execute()' when the thread pool drops the task because its
+         * deadline passed while it was waiting in the queue.
+         */
+        virtual void handleExpired();
+
     protected:
         uint64_t mTaskId;
         std::atomic_bool mCanceled;
+        std::optional<Clock::time_point> mDeadline;
+
+    private:
+        // Set by the thread pool when the task is pushed to the queue.
+        Clock::time_point mQueuedTime;
+
+        // The order in which the task entered the queue. Set by the thread pool.
+        uint64_t mQueueSequence{ 0 };
+
+        friend class ThreadPool;
     };
 }
 
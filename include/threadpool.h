@@ -9,16 +9,23 @@
 #define THREADPOOLUNIVERSE_THREADPOOL_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace threadpooluniverse
 {
+    class KeyedTask;
+    class ScratchArena;
+    class SpillFile;
     class TaskBase;
     class WorkerThread;
 
@@ -28,13 +35,173 @@ namespace threadpooluniverse
     class ThreadPool
     {
     public:
+        /**
+         * @brief Defines the order in which queued tasks are taken under execution.
+         */
+        enum class SchedulingPolicy
+        {
+            /** Tasks are executed in the order they were pushed to the queue. */
+            Fifo,
+            /** Tasks with the earliest deadline are executed first. Tasks without a deadline
+             * are executed after the tasks that have one, in the order they were pushed. */
+            EarliestDeadlineFirst
+        };
+
+        /**
+         * @brief Defines what happens to the tasks whose deadline passed while they were queued.
+         */
+        enum class ExpiryPolicy
+        {
+            /** Expired tasks are executed normally. */
+            ExecuteExpired,
+            /** Expired tasks are removed from the queue and their 'handleExpired()' is called
+             * instead of 'execute()'. */
+            DropExpired
+        };
+
+        /**
+         * @brief Defines when the worker threads are created.
+         */
+        enum class WorkerStartup
+        {
+            /** All worker threads are created in the constructor and the constructor blocks until
+             * they are running. */
+            Eager,
+            /** All worker threads are created in the constructor but the constructor does not wait
+             * for them to start running. */
+            NonBlocking,
+            /** Worker threads are created on demand when tasks are pushed to the queue and there
+             * are no idle workers to take them, up to the configured number of threads. */
+            Lazy
+        };
+
+        /**
+         * @brief Defines when the scratch arenas of the worker threads are reset. A reset keeps
+         * the memory of the arena for the next tasks unless it exceeds the retention limit of
+         * 'ScratchArena', 16 MiB by default.
+         */
+        enum class ScratchArenaReset
+        {
+            /** The arena is reset after every task. */
+            AfterEachTask,
+            /** The arena is reset only when the tasks call 'ScratchArena::reset()'. */
+            Manual
+        };
+
+        /**
+         * @brief Defines what happens when a task is pushed with a key that already has a task
+         * waiting in the queue.
+         */
+        enum class CoalescePolicy
+        {
+            /** The queued task is kept and the new task is discarded. */
+            KeepFirst,
+            /** The new task replaces the queued task in its place in the queue. */
+            KeepLast,
+            /** The merge callback merges the new task into the queued task. */
+            Merge
+        };
+
+        /**
+         * Merges the new task into the task that is waiting in the queue with the same key.
+         */
+        using MergeCallback = std::function<void( TaskBase& queuedTask, std::unique_ptr<TaskBase> newTask )>;
+
+        /**
+         * Hook function that is called in a worker thread. Gets the index of the worker thread.
+         */
+        using WorkerHook = std::function<void( size_t workerIndex )>;
+
+        /**
+         * @brief Settings of the latency based admission control.
+         *
+         * The admission control follows the queue sojourn time, the time tasks wait in the queue
+         * before execution. If the sojourn time has stayed above the target delay for at least
+         * the interval, the pool is considered overloaded and new tasks are rejected until the
+         * sojourn time drops below the target again or the queue becomes empty.
+         */
+        struct AdmissionControlSettings
+        {
+            /** Acceptable queueing delay. */
+            std::chrono::microseconds targetDelay{ std::chrono::milliseconds( 5 ) };
+            /** How long the queueing delay may stay above the target before tasks are rejected. */
+            std::chrono::microseconds interval{ std::chrono::milliseconds( 100 ) };
+        };
+
+        /**
+         * Recreates a task from the data its 'SerializableTask::serialize()' wrote. The returned
+         * task must have the given task ID.
+         */
+        using TaskDeserializer =
+            std::function<std::unique_ptr<TaskBase>( uint64_t taskId, const std::vector<char>& data )>;
+
+        /**
+         * @brief Settings of the overflow spill of the task queue.
+         *
+         * When the queue holds more tasks than the high-water mark, the pushed tasks that derive
+         * from SerializableTask are serialized to a memory-mapped spill file instead of being kept
+         * in memory. The worker threads read them back to the queue as it drains. The spilled
+         * tasks keep their order with respect to each other and to the serializable tasks queued
+         * before them. Tasks that are not serializable, including keyed tasks, bypass the spill
+         * file and go to the queue directly, so they may overtake the spilled tasks. So do the
+         * serializable tasks whose 'serialize()' throws or that do not fit in the spill file
+         * because it cannot grow. These are subject to the maximum queue size like any task.
+         *
+         * Tasks that have a deadline are never spilled. The earliest-deadline-first order and the
+         * dropping of expired tasks apply only to the queue, so a spilled task with an early
+         * deadline would wait behind the whole spill file. They also bypass the spill file and
+         * are subject to the maximum queue size.
+         *
+         * 'SerializableTask::serialize()' is called in the pushing thread and the deserializer in
+         * a worker thread without holding the queue lock, so both may use the thread pool. A
+         * spilled task cannot be canceled while a worker thread is restoring it.
+         */
+        struct SpillSettings
+        {
+            /** Directory where the spill file is created. */
+            std::string directory;
+            /** Number of queued tasks above which the serializable tasks are spilled. */
+            size_t highWaterMark{ 10000 };
+            /** Recreates the spilled tasks. Tasks for which it returns null or throws are dropped. */
+            TaskDeserializer deserializer;
+        };
+
+        /**
+         * @brief BlockingScope tells the thread pool that the task is about to block.
+         *
+         * Create a BlockingScope on stack around a blocking call inside 'TaskBase::execute()'.
+         * While the scope exists, the thread pool runs a compensating worker thread so that the
+         * number of worker threads processing tasks stays at the configured level. When the scope
+         * ends, the compensating worker stops taking new tasks. The compensating workers are kept
+         * for reuse and their number is limited by 'setMaxCompensatingThreads()'.
+         *
+         * Creating a BlockingScope in a thread that is not a worker thread has no effect. Nested
+         * scopes in the same task count as one.
+         */
+        class BlockingScope
+        {
+        public:
+            BlockingScope();
+            ~BlockingScope();
+
+            BlockingScope( const BlockingScope& ) = delete;
+            BlockingScope& operator=( const BlockingScope& ) = delete;
+            BlockingScope( BlockingScope&& ) = delete;
+            BlockingScope& operator=( BlockingScope&& ) = delete;
+
+        private:
+            WorkerThread* mWorker;
+        };
+
         /**
          * @brief Creates a thread pool with given number of threads and maximum queue size.
          * @param numOfThreads Number of worker threads.
          * @param maxQueueSize Maximum number of tasks in queue. Pass std::nullopt for unlimited
          * queue size.
+         * @param workerStartup Defines when the worker threads are created.
          */
-        ThreadPool( size_t numOfThreads, const std::optional<size_t> maxQueueSize );
+        ThreadPool( size_t numOfThreads, const std::optional<size_t> maxQueueSize,
+                    WorkerStartup workerStartup = WorkerStartup::Eager );
 
         ~ThreadPool();
 
@@ -44,6 +211,28 @@ namespace threadpooluniverse
         ThreadPool& operator=( ThreadPool&& ) = delete;
 
     public:
+        /**
+         * @brief Returns the number of worker threads that matches the CPUs the process can use.
+         *
+         * Unlike 'std::thread::hardware_concurrency()' this respects the cgroup CPU quota and the
+         * CPU affinity mask of the process, so a pool created in a container with a quota of 4
+         * CPUs gets 4 workers even if the host has 64 CPUs. See SystemResources.
+         * @return Number of usable CPUs. At least 1.
+         */
+        static size_t getDefaultNumberOfThreads();
+
+        /**
+         * @brief Returns the process-wide thread pool that independent components can share
+         * instead of each creating their own pool.
+         *
+         * The pool is created on the first call with 'getDefaultNumberOfThreads()' worker threads
+         * and an unlimited queue, and its processing is started. It is destroyed when the process
+         * exits. Do not stop its processing or change its policies, because other components
+         * depend on it too.
+         * @return The shared thread pool.
+         */
+        static ThreadPool& getSharedDefault();
+
         /**
          * @brief Generates an unique task ID. The ID is guaranteed to be unique within a thread pool instance.
          * @return Unique task ID.
@@ -69,17 +258,82 @@ namespace threadpooluniverse
          * If threadpool has been started, the task will go under execution as soon as next available
          * worker can pick it.
          * @param task The task to add. Takes the ownership of the task instance.
-         * @throws TaskQueueFullException if the task queue is full and cannot accept more tasks.
+         * @throws TaskQueueFullException if the task queue is full and cannot accept more tasks
+         * or if the admission control rejects the task because the pool is overloaded.
          */
         void pushToQueue( std::unique_ptr<TaskBase> task );
 
+        /**
+         * @brief Appends new task to processing queue unless the queue is full or the admission
+         * control rejects it. Unlike 'pushToQueue()', the rejected task is given back so that
+         * the caller can execute it some other way.
+         * @param task The task to add.
+         * @return Null if the task was added. Otherwise the rejected task.
+         */
+        std::unique_ptr<TaskBase> tryPushToQueue( std::unique_ptr<TaskBase> task );
+
+        /**
+         * @brief Appends new task to processing queue unless a task with the same key is still
+         * waiting in the queue. In that case the tasks are coalesced according to the policy and
+         * the queue does not grow.
+         *
+         * The lookup of the key takes constant time and is done under its own lock so it does
+         * not make the queue lock any more contended. A task is waiting in the queue until a
+         * worker starts executing it. Replacing or merging the task does not change its position
+         * in the queue or its deadline. A task is never coalesced with a task the queue rejects,
+         * because the tasks pushed with the same key wait until the first push has completed.
+         *
+         * @param task The task to add. Takes the ownership of the task instance.
+         * @param key The key that identifies duplicate tasks.
+         * @param policy How to coalesce the task with the queued task.
+         * @param mergeCallback Merges the tasks when the policy is CoalescePolicy::Merge. Without
+         * the callback the new task is discarded. The callback must not push tasks to this pool.
+         * @return The task ID that can be used with 'cancelTask()'. When the task is coalesced,
+         * this is the ID of the task that was first pushed with the key.
+         * @throws TaskQueueFullException if the task queue is full and cannot accept more tasks
+         * or if the admission control rejects the task because the pool is overloaded.
+         */
+        uint64_t pushToQueue( std::unique_ptr<TaskBase> task, const std::string& key,
+                              CoalescePolicy policy, MergeCallback mergeCallback = MergeCallback() );
+
+        /**
+         * @brief Returns the number of tasks that have been coalesced with a queued task instead
+         * of being added to the queue.
+         * @return Number of coalesced tasks.
+         */
+        size_t getNumberOfCoalescedTasks();
+
+        /**
+         * @brief Sets the scheduling policy. The tasks already in queue are reordered
+         * according to the new policy. Switching back to SchedulingPolicy::Fifo restores the
+         * order in which the tasks were pushed.
+         * @param policy The new scheduling policy. Default is SchedulingPolicy::Fifo.
+         */
+        void setSchedulingPolicy( SchedulingPolicy policy );
+
+        /**
+         * @brief Sets the policy for tasks whose deadline has passed while they were queued.
+         * @param policy The new expiry policy. Default is ExpiryPolicy::ExecuteExpired.
+         */
+        void setExpiryPolicy( ExpiryPolicy policy );
+
+        /**
+         * @brief Returns the number of tasks dropped from the queue because they had expired.
+         * @return Number of dropped expired tasks.
+         */
+        size_t getNumberOfExpiredTasks();
+
         /**
          * @brief Empties the task queue. Tasks currently in-processing will continue processing.
+         *
+         * Tasks that worker threads have taken from the queue in a batch but not yet started
+         * are removed as well.
          */
         void clearQueue();
 
         /**
-         * @brief Cancels the task with given ID if it is still in queue.
+         * @brief Cancels the task with given ID if it is still in queue. This includes the tasks
+         * that worker threads have taken from the queue in a batch but not yet started.
          * @return True if task was canceled, false if it was already in processing or processed.
          */
         bool cancelTask( uint64_t taskId );
@@ -96,13 +350,109 @@ namespace threadpooluniverse
         size_t getNumberOfThreads();
 
         /**
-         * @brief Returns the number of idle worker threads.
+         * @brief Sets the hooks that are called in each worker thread. The init hook is called
+         * when the worker thread sees that the processing has been started, before it takes its
+         * first task, and the teardown hook right before the worker thread exits. Both are called
+         * once in every worker thread even if it never gets a task. Set the hooks before starting
+         * the processing.
+         * @param initHook Called when the worker thread starts processing.
+         * @param teardownHook Called when the worker thread exits.
+         */
+        void setWorkerHooks( WorkerHook initHook, WorkerHook teardownHook );
+
+        /**
+         * @brief Sets when the scratch arenas of the worker threads are reset.
+         * @param reset The reset policy. Default is ScratchArenaReset::AfterEachTask.
+         */
+        void setScratchArenaReset( ScratchArenaReset reset );
+
+        /**
+         * @brief Returns the scratch arena of the calling worker thread. The running task can
+         * use it for temporary memory.
+         * @return The scratch arena or nullptr if the calling thread is not a worker thread.
+         */
+        static ScratchArena* getCurrentScratchArena();
+
+        /**
+         * @brief Enables or disables the latency based admission control. It can be used
+         * together with the maximum queue size or instead of it.
+         * @param settings The admission control settings. Pass std::nullopt to disable the
+         * admission control. Disabled by default.
+         */
+        void setAdmissionControl( std::optional<AdmissionControlSettings> settings );
+
+        /**
+         * @brief Returns true if the admission control currently rejects new tasks.
+         * @return True if overloaded.
+         */
+        bool isOverloaded();
+
+        /**
+         * @brief Returns the number of tasks the admission control has rejected.
+         * @return Number of rejected tasks.
+         */
+        size_t getNumberOfRejectedTasks();
+
+        /**
+         * @brief Enables or disables the overflow spill of the task queue. The spilled tasks are
+         * not limited by the maximum queue size, so with the spill enabled the serializable tasks
+         * are not rejected because of a full queue.
+         *
+         * Disabling the spill reads the spilled tasks back to the queue.
+         * @param settings The spill settings. Pass std::nullopt to disable the spill. Disabled by
+         * default.
+         * @throws std::system_error if the spill file cannot be created.
+         */
+        void setSpill( std::optional<SpillSettings> settings );
+
+        /**
+         * @brief Returns the number of tasks that are in the spill file. These are included in
+         * 'getNumberOfTasks()'.
+         * @return Number of spilled tasks.
+         */
+        size_t getNumberOfSpilledTasks();
+
+        /**
+         * @brief Sets the maximum number of compensating worker threads that may be processing
+         * tasks while other workers are blocked in a BlockingScope.
+         * @param maxCompensatingThreads Maximum number of compensating threads. Default is the
+         * number of worker threads. Zero disables the compensation.
+         */
+        void setMaxCompensatingThreads( size_t maxCompensatingThreads );
+
+        /**
+         * @brief Returns the number of compensating worker threads that have been created. They
+         * are not included in the other thread counts.
+         * @return Number of compensating worker threads.
+         */
+        size_t getNumberOfCompensatingThreads();
+
+        /**
+         * @brief Returns the number of idle worker threads. Worker threads that have not been
+         * created yet are not counted.
          * @return Number of idle worker threads.
          */
         size_t getNumberOfIdleThreads();
 
         /**
-         * @brief Returns true if all worker threads are running.
+         * @brief Returns the number of worker threads that have been started and are running.
+         * @return Number of running worker threads.
+         */
+        size_t getNumberOfRunningThreads();
+
+        /**
+         * @brief Returns the index of the worker thread that calls this function. The indices
+         * run from zero to 'getNumberOfThreads() - 1' and stay the same for the lifetime of the
+         * worker thread. Compensating worker threads get indices starting from
+         * 'getNumberOfThreads()'.
+         * @return Index of the calling worker thread or std::nullopt if the calling thread is not
+         * a worker thread of this thread pool.
+         */
+        std::optional<size_t> getCurrentWorkerIndex();
+
+        /**
+         * @brief Returns true if all worker threads are running. With lazy or non-blocking worker
+         * startup this becomes true only after every worker thread has been created and started.
          * @return True if all worker threads are running.
          */
         bool allThreadsRunning();
@@ -118,18 +468,51 @@ namespace threadpooluniverse
          */
         void startWorkers();
 
+        /**
+         * @brief Creates a new worker thread when lazy worker startup is used and the queued
+         * tasks outnumber the idle worker threads.
+         * @param numQueuedTasks Number of tasks in queue.
+         */
+        void startWorkerOnDemand( size_t numQueuedTasks );
+
         /**
          * @brief Shuts down the worker threads. Blocks until all threads are exited.
          */
         void shutdownWorkers();
 
         /**
-         * Gets the next task from queue for processing. Returns an empty pointer if there
-         * are no tasks in queue.
+         * Gets the next task for processing. The worker's own batch of tasks is used first. When
+         * it is empty, a new batch is taken from the queue. The batch size depends on the queue
+         * length and number of workers so that every worker gets its share of the tasks. When
+         * the queue is empty, a task is stolen from the batch of another worker. Tasks are not
+         * taken in batches while expired tasks are dropped, tasks are scheduled by deadline or
+         * admission control is enabled.
+         *
+         * If task processing has been stopped, the worker's batch is returned to the queue.
          *
-         * @param The task for processing. Empty pointer if no tasks available.
+         * @param worker The worker thread asking for a task.
+         * @return The task for processing. Empty pointer if no tasks available.
          */
-        std::unique_ptr<TaskBase> getTaskForProcessing();
+        std::unique_ptr<TaskBase> getTaskForProcessing( WorkerThread& worker );
+
+        /**
+         * Steals a task from the batch of some other worker thread.
+         */
+        std::unique_ptr<TaskBase> stealTaskFromOtherWorker( WorkerThread& worker );
+
+        /**
+         * Drops a task taken from a batch if it has expired while waiting there and expired
+         * tasks are to be dropped. The expiry handler of a dropped task is called.
+         *
+         * @param task The task taken from a batch. Reset when the task is dropped.
+         * @return True if the task was dropped.
+         */
+        bool dropIfExpired( std::unique_ptr<TaskBase>& task );
+
+        /**
+         * Returns the tasks of worker's batch back to the queue.
+         */
+        void returnBatchToQueue( WorkerThread& worker );
 
         /**
          * Called by the worker thread when it has completed a task.
@@ -138,31 +521,155 @@ namespace threadpooluniverse
 
         /**
          * To be called only from worker threads. Blocks until new tasks get added to the queue.
-         * Can return even if no tasks are added due to spurious wakeups.
+         * Can return even if no tasks are added due to spurious wakeups. Compensating workers
+         * that are not needed block until some worker enters a blocking scope.
          */
-        void waitForNotify();
+        void waitForNotify( WorkerThread& worker );
 
         /**
          * To be called only from worker threads when thread has been started and is ready
          * to start processing tasks.
          */
-        void registerRunningWorkerThread();
+        void registerRunningWorkerThread( WorkerThread& worker );
+
+        /**
+         * Returns true if 'startProcessing()' has been called and the processing has not been
+         * stopped.
+         */
+        bool isProcessingStarted() const;
+
+        /**
+         * Called by the worker thread once the processing has been started, before it takes its
+         * first task.
+         */
+        void workerInitialize( WorkerThread& worker );
+
+        /**
+         * Called by the worker thread right before it exits.
+         */
+        void workerTeardown( WorkerThread& worker );
+
+        /**
+         * Called by the worker thread after it has executed a task.
+         */
+        void workerTaskFinished( WorkerThread& worker );
+
+        /**
+         * Takes the task out from the keyed task and forgets its key so that the next task
+         * pushed with the same key is queued again. Returns empty pointer if the task has already
+         * been taken.
+         */
+        std::unique_ptr<TaskBase> takeKeyedTask( KeyedTask& keyedTask );
+
+        /**
+         * Called when a worker enters a blocking scope. Creates a compensating worker if needed.
+         */
+        void beginBlocking();
+
+        /**
+         * Called when a worker leaves a blocking scope.
+         */
+        void endBlocking();
+
+        /**
+         * Returns true if the compensating worker should be processing tasks.
+         */
+        bool isCompensationActive( const WorkerThread& worker ) const;
+
+        /**
+         * Updates the overload state of the admission control when a task is taken from the
+         * queue. Caller must hold the 'mTasksMutex'.
+         */
+        void updateAdmissionControl( const TaskBase& task, std::chrono::steady_clock::time_point now );
+
+        /**
+         * Inserts the task to the queue according to the current scheduling policy. Caller must
+         * hold the 'mTasksMutex'.
+         */
+        void insertToQueue( std::unique_ptr<TaskBase> task );
+
+        /**
+         * Adds the task to the queue. Returns null if the task was added, otherwise the reason
+         * of the rejection and the task is left untouched.
+         */
+        const char* enqueueTask( std::unique_ptr<TaskBase>& task );
+
+        /**
+         * Returns true if the spill is enabled, the task is serializable and the queue is above
+         * the high-water mark or earlier tasks are already in the spill file or being restored
+         * from it. Caller must hold the 'mTasksMutex'.
+         */
+        bool shouldSpill( const TaskBase& task ) const;
+
+        /**
+         * Serializes the task for the spill file. Returns false if the serialization throws.
+         * Called without holding the 'mTasksMutex'.
+         */
+        static bool serializeForSpill( const TaskBase& task, std::vector<char>& data );
+
+        /**
+         * Writes the serialized task to the spill file. Returns false if the spill has been
+         * disabled or the spill file cannot grow. Caller must hold the 'mTasksMutex'.
+         */
+        bool spillTask( const TaskBase& task, const std::vector<char>& data );
+
+        /**
+         * Reads spilled tasks back to the queue until the queue reaches the high-water mark or
+         * all the tasks have been read. The records are taken from the spill file under the
+         * lock but deserialized with the lock released. Returns without reading if another
+         * thread is already restoring spilled tasks. Caller must hold the 'mTasksMutex' in 'lock'.
+         */
+        void refillFromSpill( std::unique_lock<std::mutex>& lock, size_t highWaterMark );
+
+        /**
+         * Returns the number of tasks in the spill file or being restored from it. Caller must
+         * hold the 'mTasksMutex'.
+         */
+        size_t countSpilledTasks() const;
 
     private:
         std::optional<size_t> mMaxQueueSize;
         size_t mNumberOfThreads{ 5 };
         size_t mNumberOfRunningWorkerThreads{ 0 };
+        WorkerStartup mWorkerStartup{ WorkerStartup::Eager };
+        bool mWorkersShutdown{ false };
+        std::vector<std::unique_ptr<WorkerThread>> mCompensatingWorkers;
+        std::atomic_size_t mMaxCompensatingThreads;
+        std::atomic_size_t mNumberOfBlockedWorkers;
+        std::condition_variable mCompensationCV;
+        WorkerHook mWorkerInitHook;
+        WorkerHook mWorkerTeardownHook;
+        std::atomic<ScratchArenaReset> mScratchArenaReset;
+        std::unordered_map<std::string, KeyedTask*> mKeyedTasks;
+        std::mutex mKeyedTasksMutex;
+        std::condition_variable mKeyedTasksCV;
+        size_t mNumberOfCoalescedTasks{ 0 };
         std::list<std::unique_ptr<TaskBase>> mTasks;
+        uint64_t mQueueSequenceCounter{ 0 };
         std::vector<std::unique_ptr<WorkerThread>> mWorkers;
         std::mutex mWorkersMutex;
         std::mutex mTasksMutex;
         std::condition_variable mTasksCV;
         std::atomic_bool mStarted;
         std::atomic_size_t mNumberOfTasksInExecution;
+        SchedulingPolicy mSchedulingPolicy{ SchedulingPolicy::Fifo };
+        ExpiryPolicy mExpiryPolicy{ ExpiryPolicy::ExecuteExpired };
+        size_t mNumberOfExpiredTasks{ 0 };
+        std::optional<AdmissionControlSettings> mAdmissionControl;
+        std::optional<std::chrono::steady_clock::time_point> mAboveTargetDelayUntil;
+        bool mOverloaded{ false };
+        size_t mNumberOfRejectedTasks{ 0 };
+        std::optional<SpillSettings> mSpillSettings;
+        std::unique_ptr<SpillFile> mSpillFile;
+        size_t mNumberOfTasksBeingRestored{ 0 };
+        bool mRestoringSpill{ false };
+        bool mDisablingSpill{ false };
+        uint64_t mSpillGeneration{ 0 };
 
         uint64_t mTaskIdCounter{ 0 };
         std::mutex mTaskIdMutex;
 
+        friend class KeyedTask;
         friend class WorkerThread;
     };
 }
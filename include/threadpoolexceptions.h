@@ -55,5 +55,20 @@ namespace threadpooluniverse
         AlreadyCanceledException& operator=( AlreadyCanceledException&& ) = default;
     };
 
+    /**
+     * @brief Exception reported when a task was removed from the queue without executing it,
+     * for example by 'ThreadPool::clearQueue()' or 'ThreadPool::cancelTask()'.
+     */
+    class TaskDroppedException : public ThreadPoolBaseException
+    {
+    public:
+        explicit TaskDroppedException( const std::string& message );
+        virtual ~TaskDroppedException() noexcept = default;
+        TaskDroppedException( const TaskDroppedException& ) = default;
+        TaskDroppedException& operator=( const TaskDroppedException& ) = default;
+        TaskDroppedException( TaskDroppedException&& ) = default;
+        TaskDroppedException& operator=( TaskDroppedException&& ) = default;
+    };
+
 }  // namespace threadpooluniverse
 #endif
@@ -0,0 +1,469 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "../include/ioreactor.h"
+
+#if defined( __linux__ )
+
+#include "../include/callbacktask.h"
+#include "../include/threadpool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace threadpooluniverse
+{
+    namespace
+    {
+        const int kMaxEventsPerWait = 64;
+    }  // namespace
+
+    IoReactor::IoReactor( ThreadPool& threadPool ) :
+        mThreadPool( threadPool ),
+        mRequestExit( false )
+    {
+        mEpollFd = ::epoll_create1( EPOLL_CLOEXEC );
+        if( mEpollFd < 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "epoll_create1 failed" );
+        }
+        mWakeFd = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+        if( mWakeFd < 0 )
+        {
+            int error = errno;
+            ::close( mEpollFd );
+            throw std::system_error( error, std::generic_category(), "eventfd failed" );
+        }
+        epoll_event wakeEvent{};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.fd = mWakeFd;
+        if( ::epoll_ctl( mEpollFd, EPOLL_CTL_ADD, mWakeFd, &wakeEvent ) < 0 )
+        {
+            int error = errno;
+            ::close( mWakeFd );
+            ::close( mEpollFd );
+            throw std::system_error( error, std::generic_category(), "epoll_ctl failed" );
+        }
+
+        mReactorThread = std::thread( &IoReactor::threadFunction, this );
+    }
+
+    IoReactor::~IoReactor()
+    {
+        mRequestExit.store( true );
+        wakeUp();
+        if( mReactorThread.joinable() )
+        {
+            mReactorThread.join();
+        }
+        ::close( mWakeFd );
+        ::close( mEpollFd );
+    }
+
+    void IoReactor::watch( int fd, IoEvent event, std::unique_ptr<TaskBase> continuation )
+    {
+        Operation operation;
+        operation.continuation = std::move( continuation );
+        addOperation( fd, event, std::move( operation ) );
+    }
+
+    void IoReactor::submitRead( int fd, size_t maxBytes, ReadCallback callback )
+    {
+        Operation operation;
+        operation.readCallback = std::move( callback );
+        operation.maxBytes = maxBytes;
+        addOperation( fd, IoEvent::Readable, std::move( operation ) );
+    }
+
+    void IoReactor::submitWrite( int fd, std::vector<char> data, WriteCallback callback )
+    {
+        Operation operation;
+        operation.writeCallback = std::move( callback );
+        operation.data = std::move( data );
+        addOperation( fd, IoEvent::Writable, std::move( operation ) );
+    }
+
+    void IoReactor::cancel( int fd )
+    {
+        FdState canceledState;
+        {
+            std::lock_guard<std::mutex> lock( mStateMutex );
+            auto it = mFdStates.find( fd );
+            if( it == mFdStates.end() )
+            {
+                return;
+            }
+            if( it->second.registeredEvents != 0 )
+            {
+                ::epoll_ctl( mEpollFd, EPOLL_CTL_DEL, fd, nullptr );
+            }
+            canceledState = std::move( it->second );
+            mFdStates.erase( it );
+        }
+
+        // Report the cancellation to the reads and writes. Watch continuations are just dropped.
+        for( auto& operation : canceledState.readOperations )
+        {
+            if( operation.readCallback )
+            {
+                auto callback = std::move( operation.readCallback );
+                deliver( std::make_unique<CallbackTask>(
+                    mThreadPool.generateId(),
+                    [callback = std::move( callback )]() mutable { callback( std::vector<char>(), ECANCELED ); } ) );
+            }
+        }
+        for( auto& operation : canceledState.writeOperations )
+        {
+            auto callback = std::move( operation.writeCallback );
+            size_t bytesWritten = operation.bytesDone;
+            deliver( std::make_unique<CallbackTask>(
+                mThreadPool.generateId(),
+                [callback = std::move( callback ), bytesWritten]() mutable { callback( bytesWritten, ECANCELED ); } ) );
+        }
+    }
+
+    size_t IoReactor::getNumberOfPendingOperations()
+    {
+        std::lock_guard<std::mutex> lock( mStateMutex );
+        size_t numOperations = 0;
+        for( auto& fdState : mFdStates )
+        {
+            numOperations += fdState.second.readOperations.size();
+            numOperations += fdState.second.writeOperations.size();
+        }
+        return numOperations;
+    }
+
+    void IoReactor::threadFunction( IoReactor* reactor )
+    {
+        reactor->threadMain();
+    }
+
+    void IoReactor::threadMain()
+    {
+        // Writing to a pipe or socket whose reader has closed raises SIGPIPE, which would
+        // terminate the process. With the signal blocked in the thread that does the writes,
+        // the write fails with EPIPE that is reported to the callback instead.
+        sigset_t signals;
+        sigemptyset( &signals );
+        sigaddset( &signals, SIGPIPE );
+        ::pthread_sigmask( SIG_BLOCK, &signals, nullptr );
+
+        epoll_event events[ kMaxEventsPerWait ];
+        while( !mRequestExit.load() )
+        {
+            int numEvents = ::epoll_wait( mEpollFd, events, kMaxEventsPerWait, -1 );
+            if( numEvents < 0 )
+            {
+                // Interrupted by a signal. Just wait again.
+                continue;
+            }
+
+            for( int i = 0; i < numEvents; ++i )
+            {
+                if( events[ i ].data.fd == mWakeFd )
+                {
+                    uint64_t counter = 0;
+                    while( ::read( mWakeFd, &counter, sizeof( counter ) ) > 0 )
+                    {
+                    }
+                    continue;
+                }
+                processFd( events[ i ].data.fd, events[ i ].events );
+            }
+
+            // Complete the operations of the file descriptors that epoll cannot wait for.
+            std::vector<int> readyFds;
+            {
+                std::lock_guard<std::mutex> lock( mStateMutex );
+                readyFds.swap( mReadyFds );
+            }
+            for( int fd : readyFds )
+            {
+                processFd( fd, EPOLLIN | EPOLLOUT );
+            }
+        }
+    }
+
+    void IoReactor::addOperation( int fd, IoEvent event, Operation operation )
+    {
+        std::lock_guard<std::mutex> lock( mStateMutex );
+        auto insertResult = mFdStates.try_emplace( fd );
+        FdState& state = insertResult.first->second;
+        if( insertResult.second )
+        {
+            int flags = ::fcntl( fd, F_GETFL );
+            if( flags < 0 )
+            {
+                int error = errno;
+                mFdStates.erase( insertResult.first );
+                throw std::system_error( error, std::generic_category(), "Invalid file descriptor" );
+            }
+            ::fcntl( fd, F_SETFL, flags | O_NONBLOCK );
+        }
+
+        if( event == IoEvent::Readable )
+        {
+            state.readOperations.push_back( std::move( operation ) );
+        }
+        else
+        {
+            state.writeOperations.push_back( std::move( operation ) );
+        }
+
+        try
+        {
+            updateRegistration( fd, state );
+        }
+        catch( const std::system_error& )
+        {
+            if( event == IoEvent::Readable )
+            {
+                state.readOperations.pop_back();
+            }
+            else
+            {
+                state.writeOperations.pop_back();
+            }
+            if( state.readOperations.empty() && state.writeOperations.empty() &&
+                state.registeredEvents == 0 )
+            {
+                mFdStates.erase( fd );
+            }
+            throw;
+        }
+    }
+
+    void IoReactor::updateRegistration( int fd, FdState& state )
+    {
+        uint32_t wantedEvents = 0;
+        if( !state.readOperations.empty() )
+        {
+            wantedEvents |= EPOLLIN;
+        }
+        if( !state.writeOperations.empty() )
+        {
+            wantedEvents |= EPOLLOUT;
+        }
+
+        if( !state.pollable )
+        {
+            if( wantedEvents != 0 &&
+                std::find( mReadyFds.begin(), mReadyFds.end(), fd ) == mReadyFds.end() )
+            {
+                mReadyFds.push_back( fd );
+                wakeUp();
+            }
+            return;
+        }
+        if( wantedEvents == state.registeredEvents )
+        {
+            return;
+        }
+
+        epoll_event event{};
+        event.events = wantedEvents;
+        event.data.fd = fd;
+        int result = 0;
+        if( wantedEvents == 0 )
+        {
+            result = ::epoll_ctl( mEpollFd, EPOLL_CTL_DEL, fd, nullptr );
+        }
+        else if( state.registeredEvents == 0 )
+        {
+            result = ::epoll_ctl( mEpollFd, EPOLL_CTL_ADD, fd, &event );
+        }
+        else
+        {
+            result = ::epoll_ctl( mEpollFd, EPOLL_CTL_MOD, fd, &event );
+        }
+
+        if( result < 0 )
+        {
+            if( errno == EPERM )
+            {
+                // Regular files are always ready for I/O and cannot be added to epoll.
+                state.pollable = false;
+                state.registeredEvents = 0;
+                updateRegistration( fd, state );
+                return;
+            }
+            throw std::system_error( errno, std::generic_category(), "epoll_ctl failed" );
+        }
+        state.registeredEvents = wantedEvents;
+    }
+
+    void IoReactor::processFd( int fd, uint32_t events )
+    {
+        std::vector<std::unique_ptr<TaskBase>> completions;
+        {
+            std::lock_guard<std::mutex> lock( mStateMutex );
+            auto it = mFdStates.find( fd );
+            if( it == mFdStates.end() )
+            {
+                return;
+            }
+            FdState& state = it->second;
+
+            if( events & ( EPOLLIN | EPOLLHUP | EPOLLERR ) )
+            {
+                while( !state.readOperations.empty() )
+                {
+                    auto completion = tryComplete( fd, IoEvent::Readable, state.readOperations.front() );
+                    if( !completion )
+                    {
+                        break;
+                    }
+                    completions.push_back( std::move( completion ) );
+                    state.readOperations.pop_front();
+                }
+            }
+            if( events & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) )
+            {
+                while( !state.writeOperations.empty() )
+                {
+                    auto completion = tryComplete( fd, IoEvent::Writable, state.writeOperations.front() );
+                    if( !completion )
+                    {
+                        break;
+                    }
+                    completions.push_back( std::move( completion ) );
+                    state.writeOperations.pop_front();
+                }
+            }
+
+            try
+            {
+                updateRegistration( fd, state );
+            }
+            catch( const std::system_error& )
+            {
+                // The file descriptor has been closed without canceling its operations. There
+                // is no one to report the error so just forget the file descriptor.
+                state.readOperations.clear();
+                state.writeOperations.clear();
+                state.registeredEvents = 0;
+            }
+            if( state.readOperations.empty() && state.writeOperations.empty() &&
+                state.registeredEvents == 0 )
+            {
+                mFdStates.erase( it );
+            }
+        }
+
+        for( auto& completion : completions )
+        {
+            deliver( std::move( completion ) );
+        }
+    }
+
+    void IoReactor::deliver( std::unique_ptr<TaskBase> completion )
+    {
+        completion = mThreadPool.tryPushToQueue( std::move( completion ) );
+        if( !completion )
+        {
+            return;
+        }
+
+        // The read data has already been consumed from the file descriptor so the completion
+        // must not be dropped. Execute it here when the queue cannot take it.
+        try
+        {
+            completion->execute();
+        }
+        catch( const std::exception& )
+        {
+            try
+            {
+                completion->handleError();
+            }
+            catch( const std::exception& )
+            {
+                // Don't let exceptions terminate the reactor thread.
+            }
+        }
+    }
+
+    std::unique_ptr<TaskBase> IoReactor::tryComplete( int fd, IoEvent event, Operation& operation )
+    {
+        if( operation.continuation )
+        {
+            return std::move( operation.continuation );
+        }
+
+        if( event == IoEvent::Readable )
+        {
+            std::vector<char> data( operation.maxBytes );
+            ssize_t bytesRead = 0;
+            do
+            {
+                bytesRead = ::read( fd, data.data(), data.size() );
+            } while( bytesRead < 0 && errno == EINTR );
+
+            int error = 0;
+            if( bytesRead < 0 )
+            {
+                if( errno == EAGAIN || errno == EWOULDBLOCK )
+                {
+                    return nullptr;
+                }
+                error = errno;
+                bytesRead = 0;
+            }
+            data.resize( static_cast<size_t>( bytesRead ) );
+            auto callback = std::move( operation.readCallback );
+            return std::make_unique<CallbackTask>(
+                mThreadPool.generateId(), [callback = std::move( callback ), data = std::move( data ), error]() mutable {
+                    callback( std::move( data ), error );
+                } );
+        }
+
+        int error = 0;
+        while( operation.bytesDone < operation.data.size() )
+        {
+            ssize_t bytesWritten = ::write( fd, operation.data.data() + operation.bytesDone,
+                                            operation.data.size() - operation.bytesDone );
+            if( bytesWritten < 0 )
+            {
+                if( errno == EINTR )
+                {
+                    continue;
+                }
+                if( errno == EAGAIN || errno == EWOULDBLOCK )
+                {
+                    return nullptr;
+                }
+                error = errno;
+                break;
+            }
+            operation.bytesDone += static_cast<size_t>( bytesWritten );
+        }
+        auto callback = std::move( operation.writeCallback );
+        size_t bytesWritten = operation.bytesDone;
+        return std::make_unique<CallbackTask>(
+            mThreadPool.generateId(),
+            [callback = std::move( callback ), bytesWritten, error]() mutable { callback( bytesWritten, error ); } );
+    }
+
+    void IoReactor::wakeUp()
+    {
+        uint64_t one = 1;
+        ssize_t result = ::write( mWakeFd, &one, sizeof( one ) );
+        (void) result;
+    }
+
+}  // namespace threadpooluniverse
+
+#endif  // __linux__
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "keyedtask.h"
+#include "../include/threadpool.h"
+
+namespace threadpooluniverse
+{
+    KeyedTask::KeyedTask( ThreadPool& owningThreadPool, const std::string& key,
+                          std::unique_ptr<TaskBase> task ) :
+        TaskBase( task->getTaskId() ),
+        mOwningThreadPool( owningThreadPool ),
+        mKey( key ),
+        mTask( std::move( task ) )
+    {
+        mDeadline = mTask->getDeadline();
+    }
+
+    KeyedTask::~KeyedTask()
+    {
+        // Forget the key if the task gets destroyed without being executed, for example
+        // when it is canceled.
+        mOwningThreadPool.takeKeyedTask( *this );
+    }
+
+    const std::string& KeyedTask::getKey() const
+    {
+        return mKey;
+    }
+
+    void KeyedTask::execute()
+    {
+        mTakenTask = mOwningThreadPool.takeKeyedTask( *this );
+        if( mTakenTask && !isCanceled() )
+        {
+            mTakenTask->execute();
+        }
+    }
+
+    void KeyedTask::handleError()
+    {
+        if( mTakenTask )
+        {
+            mTakenTask->handleError();
+        }
+    }
+
+    void KeyedTask::handleExpired()
+    {
+        mTakenTask = mOwningThreadPool.takeKeyedTask( *this );
+        if( mTakenTask )
+        {
+            mTakenTask->handleExpired();
+        }
+    }
+
+}  // namespace threadpooluniverse
@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_KEYEDTASK_H
+#define THREADPOOLUNIVERSE_KEYEDTASK_H
+
+#include "../include/taskbase.h"
+
+#include <memory>
+#include <string>
+
+namespace threadpooluniverse
+{
+    class ThreadPool;
+
+    /**
+     * @brief KeyedTask stands in the queue for the task that was pushed with a key.
+     *
+     * The actual task can be replaced or merged with new tasks pushed with the same key until
+     * a worker thread starts executing the keyed task. The actual task is guarded by the keyed
+     * tasks mutex of the thread pool, not by the queue mutex.
+     */
+    class KeyedTask : public TaskBase
+    {
+    public:
+        KeyedTask( ThreadPool& owningThreadPool, const std::string& key, std::unique_ptr<TaskBase> task );
+        virtual ~KeyedTask();
+
+    public:
+        const std::string& getKey() const;
+
+    public:  // from TaskBase
+        virtual void execute() override;
+        virtual void handleError() override;
+        virtual void handleExpired() override;
+
+    private:
+        ThreadPool& mOwningThreadPool;
+        std::string mKey;
+
+        // The task while it is waiting in the queue. Guarded by the keyed tasks mutex.
+        std::unique_ptr<TaskBase> mTask;
+
+        // The task after it has been taken for execution.
+        std::unique_ptr<TaskBase> mTakenTask;
+
+        // True until the push of this task to the queue has completed. New tasks with the same
+        // key are not coalesced with it before that. Guarded by the keyed tasks mutex.
+        bool mPushing{ true };
+
+        friend class ThreadPool;
+    };
+}  // namespace threadpooluniverse
+
+#endif
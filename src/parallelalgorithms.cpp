@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "../include/parallelalgorithms.h"
+#include "../include/callbacktask.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace threadpooluniverse
+{
+    namespace
+    {
+        /**
+         * State shared by the calling thread and the helper tasks of a parallelFor() call. The
+         * helper tasks may run after the call has returned, so they own the state together with
+         * the caller. The body is only accessed after an index has been taken, which cannot
+         * happen once the call has returned.
+         */
+        struct ParallelForState
+        {
+            const std::function<void( size_t )>* body{ nullptr };
+            size_t count{ 0 };
+            std::atomic<size_t> nextIndex{ 0 };
+            size_t numCompleted{ 0 };
+            std::exception_ptr exception;
+            std::mutex mutex;
+            std::condition_variable completedCV;
+        };
+
+        void processIndices( ParallelForState& state )
+        {
+            size_t numProcessed = 0;
+            std::exception_ptr exception;
+            for( size_t index = state.nextIndex++; index < state.count; index = state.nextIndex++ )
+            {
+                ++numProcessed;
+                try
+                {
+                    ( *state.body )( index );
+                }
+                catch( ... )
+                {
+                    exception = std::current_exception();
+                    // Skip the indices nobody has taken yet. They count as completed.
+                    size_t skipFrom = state.nextIndex.exchange( state.count );
+                    numProcessed += skipFrom < state.count ? state.count - skipFrom : 0;
+                    break;
+                }
+            }
+            if( numProcessed == 0 )
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock( state.mutex );
+            if( exception && !state.exception )
+            {
+                state.exception = exception;
+            }
+            state.numCompleted += numProcessed;
+            if( state.numCompleted == state.count )
+            {
+                state.completedCV.notify_all();
+            }
+        }
+    }  // namespace
+
+    void parallelFor( ThreadPool& threadPool, size_t count, const std::function<void( size_t index )>& body )
+    {
+        if( count == 0 )
+        {
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState>();
+        state->body = &body;
+        state->count = count;
+
+        // The calling thread processes indices too, so one helper less is enough.
+        size_t numHelpers = std::min( count - 1, threadPool.getNumberOfThreads() );
+        for( size_t i = 0; i < numHelpers; ++i )
+        {
+            auto rejectedTask = threadPool.tryPushToQueue( std::make_unique<CallbackTask>(
+                threadPool.generateId(), [state]() { processIndices( *state ); } ) );
+            if( rejectedTask )
+            {
+                // The calling thread does the work the helpers would have done.
+                break;
+            }
+        }
+
+        processIndices( *state );
+
+        std::unique_lock<std::mutex> lock( state->mutex );
+        state->completedCV.wait( lock, [&state]() { return state->numCompleted == state->count; } );
+        if( state->exception )
+        {
+            std::rethrow_exception( state->exception );
+        }
+    }
+
+}  // namespace threadpooluniverse
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "../include/scratcharena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace threadpooluniverse
+{
+    ScratchArena::ScratchArena( size_t blockSize, size_t maxRetainedCapacity ) :
+        mBlockSize( blockSize > 0 ? blockSize : 1 ),
+        mMaxRetainedCapacity( maxRetainedCapacity )
+    {
+    }
+
+    ScratchArena::~ScratchArena()
+    {
+    }
+
+    void* ScratchArena::allocate( size_t size, size_t alignment )
+    {
+        while( mCurrentBlock < mBlocks.size() )
+        {
+            Block& block = mBlocks[ mCurrentBlock ];
+            uintptr_t base = reinterpret_cast<uintptr_t>( block.data.get() );
+            uintptr_t address = ( base + mCurrentOffset + alignment - 1 ) & ~( uintptr_t( alignment ) - 1 );
+            size_t newOffset = static_cast<size_t>( address - base ) + size;
+            if( newOffset <= block.size )
+            {
+                mBytesAllocated += newOffset - mCurrentOffset;
+                mCurrentOffset = newOffset;
+                return reinterpret_cast<void*>( address );
+            }
+
+            // Continue from the next block. The rest of this block stays unused until reset.
+            ++mCurrentBlock;
+            mCurrentOffset = 0;
+        }
+
+        // None of the blocks has enough room. Add a new block that fits the allocation.
+        if( size > SIZE_MAX - alignment )
+        {
+            throw std::bad_alloc();
+        }
+        Block block;
+        block.size = std::max( mBlockSize, size + alignment );
+        block.data.reset( new unsigned char[ block.size ] );
+        mBlocks.push_back( std::move( block ) );
+        mCurrentBlock = mBlocks.size() - 1;
+        mCurrentOffset = 0;
+        return allocate( size, alignment );
+    }
+
+    void ScratchArena::reset()
+    {
+        if( getCapacity() > mMaxRetainedCapacity )
+        {
+            // Don't hold on to the memory of an exceptionally big round of allocations.
+            mBlocks.clear();
+        }
+        else if( mBlocks.size() > 1 )
+        {
+            // Use one block that fits everything so that the next round of allocations does not
+            // need to jump between blocks.
+            size_t capacity = getCapacity();
+            mBlocks.clear();
+            Block block;
+            block.size = capacity;
+            block.data.reset( new unsigned char[ block.size ] );
+            mBlocks.push_back( std::move( block ) );
+        }
+        mCurrentBlock = 0;
+        mCurrentOffset = 0;
+        mBytesAllocated = 0;
+    }
+
+    size_t ScratchArena::getBytesAllocated() const
+    {
+        return mBytesAllocated;
+    }
+
+    size_t ScratchArena::getCapacity() const
+    {
+        size_t capacity = 0;
+        for( auto& block : mBlocks )
+        {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+}  // namespace threadpooluniverse
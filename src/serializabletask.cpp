@@ -0,0 +1,21 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "../include/serializabletask.h"
+
+namespace threadpooluniverse
+{
+    SerializableTask::SerializableTask( uint64_t taskId ) :
+        TaskBase( taskId )
+    {
+    }
+
+    SerializableTask::~SerializableTask()
+    {
+    }
+
+}  // namespace threadpooluniverse
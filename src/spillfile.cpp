@@ -0,0 +1,338 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "spillfile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#endif
+
+namespace threadpooluniverse
+{
+    namespace
+    {
+        int64_t toTicks( TaskBase::Clock::time_point timePoint )
+        {
+            return static_cast<int64_t>( timePoint.time_since_epoch().count() );
+        }
+
+        TaskBase::Clock::time_point fromTicks( int64_t ticks )
+        {
+            return TaskBase::Clock::time_point( TaskBase::Clock::duration( ticks ) );
+        }
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+        // The pages that have been read are released in chunks of this size.
+        const size_t kReleaseChunkSize = 256 * 1024;
+#endif
+    }  // namespace
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+    SpillFile::SpillFile( const std::string& directory )
+    {
+        std::string pathTemplate = directory + "/threadpooluniverse_spill_XXXXXX";
+        std::vector<char> path( pathTemplate.begin(), pathTemplate.end() );
+        path.push_back( '\0' );
+        mFd = ::mkstemp( path.data() );
+        if( mFd < 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "Cannot create spill file" );
+        }
+        // The file stays accessible through the descriptor and disappears when it is closed.
+        ::unlink( path.data() );
+        try
+        {
+            resize( kInitialCapacity );
+        }
+        catch( ... )
+        {
+            ::close( mFd );
+            throw;
+        }
+    }
+
+    SpillFile::~SpillFile()
+    {
+        if( mMapping != nullptr )
+        {
+            ::munmap( mMapping, mCapacity );
+        }
+        ::close( mFd );
+    }
+
+    void SpillFile::resize( size_t capacity )
+    {
+        // Nothing is changed before the new mapping exists so that a failure leaves the records
+        // readable.
+        if( capacity > mCapacity )
+        {
+            reserve( capacity );
+        }
+
+        void* mapping = MAP_FAILED;
+        if( mMapping == nullptr )
+        {
+            mapping = ::mmap( nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0 );
+        }
+        else
+        {
+#if defined( __linux__ )
+            mapping = ::mremap( mMapping, mCapacity, capacity, MREMAP_MAYMOVE );
+#else
+            mapping = ::mmap( nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0 );
+            if( mapping != MAP_FAILED )
+            {
+                ::munmap( mMapping, mCapacity );
+            }
+#endif
+        }
+        if( mapping == MAP_FAILED )
+        {
+            if( capacity < mCapacity )
+            {
+                // Shrinking is only an optimization. Keep using the bigger mapping.
+                return;
+            }
+            throw std::system_error( errno, std::generic_category(), "Cannot map spill file" );
+        }
+
+        if( capacity < mCapacity )
+        {
+            // A failure just leaves the file bigger than needed.
+            ( void )::ftruncate( mFd, static_cast<off_t>( capacity ) );
+        }
+        mMapping = static_cast<char*>( mapping );
+        mCapacity = capacity;
+        size_t pageSize = static_cast<size_t>( ::sysconf( _SC_PAGESIZE ) );
+        mReleasedOffset = mReadOffset / pageSize * pageSize;
+    }
+
+    void SpillFile::reserve( size_t capacity )
+    {
+#if defined( __linux__ )
+        // Allocate the blocks now. A sparse file would raise SIGBUS on a write through the
+        // mapping when the disk is full.
+        int error = ::posix_fallocate( mFd, static_cast<off_t>( mCapacity ),
+                                       static_cast<off_t>( capacity - mCapacity ) );
+        if( error != 0 )
+        {
+            throw std::system_error( error, std::generic_category(), "Cannot resize spill file" );
+        }
+#else
+        if( ::ftruncate( mFd, static_cast<off_t>( capacity ) ) != 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "Cannot resize spill file" );
+        }
+#endif
+    }
+
+    void SpillFile::writeAt( size_t offset, const void* data, size_t size )
+    {
+        std::memcpy( mMapping + offset, data, size );
+    }
+
+    void SpillFile::readAt( size_t offset, void* data, size_t size )
+    {
+        std::memcpy( data, mMapping + offset, size );
+    }
+#else
+    SpillFile::SpillFile( const std::string& directory )
+    {
+        static std::atomic<uint64_t> fileCounter{ 0 };
+        mPath = directory + "/threadpooluniverse_spill_" +
+                std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() ) + "_" +
+                std::to_string( ++fileCounter );
+        mStream.open( mPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc );
+        if( !mStream.is_open() )
+        {
+            throw std::system_error( std::make_error_code( std::errc::io_error ), "Cannot create spill file" );
+        }
+        resize( kInitialCapacity );
+    }
+
+    SpillFile::~SpillFile()
+    {
+        mStream.close();
+        std::error_code error;
+        std::filesystem::remove( mPath, error );
+    }
+
+    void SpillFile::resize( size_t capacity )
+    {
+        // The stream grows the file when writing. The file is not truncated when the capacity
+        // shrinks, its beginning is just reused.
+        mCapacity = capacity;
+    }
+
+    void SpillFile::writeAt( size_t offset, const void* data, size_t size )
+    {
+        mStream.seekp( static_cast<std::streamoff>( offset ) );
+        mStream.write( static_cast<const char*>( data ), static_cast<std::streamsize>( size ) );
+        if( !mStream )
+        {
+            mStream.clear();
+            throw std::system_error( std::make_error_code( std::errc::io_error ), "Cannot write spill file" );
+        }
+    }
+
+    void SpillFile::readAt( size_t offset, void* data, size_t size )
+    {
+        mStream.seekg( static_cast<std::streamoff>( offset ) );
+        mStream.read( static_cast<char*>( data ), static_cast<std::streamsize>( size ) );
+        if( !mStream )
+        {
+            mStream.clear();
+            throw std::system_error( std::make_error_code( std::errc::io_error ), "Cannot read spill file" );
+        }
+    }
+#endif
+
+    void SpillFile::append( uint64_t taskId, TaskBase::Clock::time_point queuedTime,
+                            std::optional<TaskBase::Clock::time_point> deadline, const std::vector<char>& data )
+    {
+        if( data.size() > std::numeric_limits<uint32_t>::max() )
+        {
+            throw std::length_error( "Spill record is too big" );
+        }
+
+        RecordHeader header{};
+        header.taskId = taskId;
+        header.queuedTime = toTicks( queuedTime );
+        header.deadline = deadline.has_value() ? toTicks( deadline.value() ) : 0;
+        header.size = static_cast<uint32_t>( data.size() );
+        header.flags = deadline.has_value() ? kHasDeadline : 0;
+
+        size_t recordLength = getRecordLength( header );
+        ensureCapacity( mWriteOffset + recordLength );
+        writeAt( mWriteOffset, &header, sizeof( header ) );
+        if( !data.empty() )
+        {
+            writeAt( mWriteOffset + sizeof( header ), data.data(), data.size() );
+        }
+        mWriteOffset += recordLength;
+        ++mNumberOfRecords;
+    }
+
+    bool SpillFile::read( Record& record )
+    {
+        while( mReadOffset < mWriteOffset )
+        {
+            RecordHeader header;
+            readAt( mReadOffset, &header, sizeof( header ) );
+            size_t recordOffset = mReadOffset;
+            mReadOffset += getRecordLength( header );
+            if( ( header.flags & kRemoved ) != 0 )
+            {
+                continue;
+            }
+
+            record.taskId = header.taskId;
+            record.queuedTime = fromTicks( header.queuedTime );
+            record.deadline.reset();
+            if( ( header.flags & kHasDeadline ) != 0 )
+            {
+                record.deadline = fromTicks( header.deadline );
+            }
+            record.data.resize( header.size );
+            if( header.size > 0 )
+            {
+                readAt( recordOffset + sizeof( header ), record.data.data(), header.size );
+            }
+            --mNumberOfRecords;
+
+            if( mNumberOfRecords == 0 )
+            {
+                clear();
+            }
+#if defined( __unix__ ) || defined( __APPLE__ )
+            else
+            {
+                // Give the pages that have been read back to the system.
+                size_t pageSize = static_cast<size_t>( ::sysconf( _SC_PAGESIZE ) );
+                size_t releaseEnd = mReadOffset / pageSize * pageSize;
+                if( releaseEnd >= mReleasedOffset + kReleaseChunkSize )
+                {
+                    ::madvise( mMapping + mReleasedOffset, releaseEnd - mReleasedOffset, MADV_DONTNEED );
+                    mReleasedOffset = releaseEnd;
+                }
+            }
+#endif
+            return true;
+        }
+        clear();
+        return false;
+    }
+
+    bool SpillFile::remove( uint64_t taskId )
+    {
+        size_t offset = mReadOffset;
+        while( offset < mWriteOffset )
+        {
+            RecordHeader header;
+            readAt( offset, &header, sizeof( header ) );
+            if( header.taskId == taskId && ( header.flags & kRemoved ) == 0 )
+            {
+                header.flags |= kRemoved;
+                writeAt( offset, &header, sizeof( header ) );
+                --mNumberOfRecords;
+                if( mNumberOfRecords == 0 )
+                {
+                    clear();
+                }
+                return true;
+            }
+            offset += getRecordLength( header );
+        }
+        return false;
+    }
+
+    void SpillFile::clear()
+    {
+        mReadOffset = 0;
+        mWriteOffset = 0;
+        mNumberOfRecords = 0;
+        if( mCapacity > kInitialCapacity )
+        {
+            resize( kInitialCapacity );
+        }
+    }
+
+    size_t SpillFile::getNumberOfRecords() const
+    {
+        return mNumberOfRecords;
+    }
+
+    size_t SpillFile::getRecordLength( const RecordHeader& header )
+    {
+        // Keep the headers aligned.
+        size_t length = sizeof( RecordHeader ) + header.size;
+        return ( length + alignof( RecordHeader ) - 1 ) / alignof( RecordHeader ) * alignof( RecordHeader );
+    }
+
+    void SpillFile::ensureCapacity( size_t capacity )
+    {
+        if( capacity > mCapacity )
+        {
+            resize( std::max( mCapacity * 2, capacity ) );
+        }
+    }
+
+}  // namespace threadpooluniverse
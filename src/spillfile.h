@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#ifndef THREADPOOLUNIVERSE_SPILLFILE_H
+#define THREADPOOLUNIVERSE_SPILLFILE_H
+
+#include "../include/taskbase.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if !defined( __unix__ ) && !defined( __APPLE__ )
+#include <fstream>
+#endif
+
+namespace threadpooluniverse
+{
+    /**
+     * @brief SpillFile is an append-only file of serialized tasks that are read back in the
+     * order they were written.
+     *
+     * On POSIX systems the file is memory-mapped and unlinked right after it has been created so
+     * it disappears with the process. Elsewhere it is accessed with file streams and removed by
+     * the destructor. When all the records have been read, the file is truncated back to its
+     * initial size so that a burst does not leave a big file behind. In Linux the blocks of the
+     * file are allocated when it grows, so a full disk is reported as std::system_error from
+     * 'append()' and not as SIGBUS when writing through the mapping. If growing fails, the
+     * records that were already in the file stay readable.
+     */
+    class SpillFile
+    {
+    public:
+        struct Record
+        {
+            uint64_t taskId{ 0 };
+            TaskBase::Clock::time_point queuedTime;
+            std::optional<TaskBase::Clock::time_point> deadline;
+            std::vector<char> data;
+        };
+
+        /**
+         * @brief Creates the spill file.
+         * @param directory Directory where the file is created.
+         * @throws std::system_error if the file cannot be created.
+         */
+        explicit SpillFile( const std::string& directory );
+        ~SpillFile();
+
+        SpillFile( const SpillFile& ) = delete;
+        SpillFile& operator=( const SpillFile& ) = delete;
+        SpillFile( SpillFile&& ) = delete;
+        SpillFile& operator=( SpillFile&& ) = delete;
+
+    public:
+        /**
+         * @brief Appends a record to the end of the file.
+         * @throws std::system_error if the file cannot be grown.
+         * @throws std::length_error if the data does not fit in a record, i.e. exceeds 4 GiB.
+         */
+        void append( uint64_t taskId, TaskBase::Clock::time_point queuedTime,
+                     std::optional<TaskBase::Clock::time_point> deadline, const std::vector<char>& data );
+
+        /**
+         * @brief Reads the oldest record that has not been read or removed.
+         * @param record Receives the record. Its data buffer is reused.
+         * @return False if there are no more records.
+         */
+        bool read( Record& record );
+
+        /**
+         * @brief Marks the record of the task removed so that it will not be read.
+         * @return True if the record was found.
+         */
+        bool remove( uint64_t taskId );
+
+        /**
+         * @brief Removes all the records.
+         */
+        void clear();
+
+        /**
+         * @brief Returns the number of records that have not been read or removed.
+         */
+        size_t getNumberOfRecords() const;
+
+    private:
+        struct RecordHeader
+        {
+            uint64_t taskId;
+            int64_t queuedTime;
+            int64_t deadline;
+            uint32_t size;
+            uint32_t flags;
+        };
+
+        static const uint32_t kHasDeadline = 1;
+        static const uint32_t kRemoved = 2;
+        static const size_t kInitialCapacity = 1024 * 1024;
+
+        static size_t getRecordLength( const RecordHeader& header );
+
+        void ensureCapacity( size_t capacity );
+        void resize( size_t capacity );
+#if defined( __unix__ ) || defined( __APPLE__ )
+        void reserve( size_t capacity );
+#endif
+        void writeAt( size_t offset, const void* data, size_t size );
+        void readAt( size_t offset, void* data, size_t size );
+
+    private:
+        size_t mCapacity{ 0 };
+        size_t mReadOffset{ 0 };
+        size_t mWriteOffset{ 0 };
+        size_t mNumberOfRecords{ 0 };
+#if defined( __unix__ ) || defined( __APPLE__ )
+        int mFd{ -1 };
+        char* mMapping{ nullptr };
+        // Pages before this offset have been released after reading them.
+        size_t mReleasedOffset{ 0 };
+#else
+        std::string mPath;
+        std::fstream mStream;
+#endif
+    };
+
+}  // namespace threadpooluniverse
+
+#endif  // THREADPOOLUNIVERSE_SPILLFILE_H
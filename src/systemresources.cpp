@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include "../include/systemresources.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined( __linux__ )
+#include <sched.h>
+#endif
+
+namespace threadpooluniverse
+{
+    namespace
+    {
+        /**
+         * Calls the function for the cgroup directory and each of its parents up to the root.
+         * When the process runs in a container, its cgroup path often refers to the host
+         * hierarchy and does not exist under the mount point. Then only the root of the mount,
+         * which is the cgroup of the container, has the files.
+         */
+        template <typename Function>
+        void forEachCgroupDirectory( const std::string& mountPoint, std::string cgroupPath, Function function )
+        {
+            while( !cgroupPath.empty() && cgroupPath.back() == '/' )
+            {
+                cgroupPath.pop_back();
+            }
+            while( true )
+            {
+                function( mountPoint + cgroupPath );
+                if( cgroupPath.empty() )
+                {
+                    break;
+                }
+                size_t lastSlash = cgroupPath.rfind( '/' );
+                if( lastSlash == std::string::npos )
+                {
+                    // Malformed path. Only the root of the mount is left to check.
+                    lastSlash = 0;
+                }
+                cgroupPath.erase( lastSlash );
+            }
+        }
+
+        void keepSmallest( std::optional<double>& smallest, std::optional<double> value )
+        {
+            if( value.has_value() && ( !smallest.has_value() || value.value() < smallest.value() ) )
+            {
+                smallest = value;
+            }
+        }
+    }  // namespace
+
+    SystemResources::SystemResources( std::string cgroupRoot, std::string procSelfCgroup ) :
+        mCgroupRoot( std::move( cgroupRoot ) ),
+        mProcSelfCgroup( std::move( procSelfCgroup ) )
+    {
+    }
+
+    std::optional<double> SystemResources::getCpuQuota() const
+    {
+        std::ifstream cgroupFile( mProcSelfCgroup );
+        std::optional<double> quota;
+        std::string line;
+        while( std::getline( cgroupFile, line ) )
+        {
+            // Each line is "hierarchy-ID:controller-list:cgroup-path".
+            size_t firstColon = line.find( ':' );
+            size_t secondColon = line.find( ':', firstColon + 1 );
+            if( firstColon == std::string::npos || secondColon == std::string::npos )
+            {
+                continue;
+            }
+            std::string controllers = line.substr( firstColon + 1, secondColon - firstColon - 1 );
+            std::string cgroupPath = line.substr( secondColon + 1 );
+
+            if( controllers.empty() )
+            {
+                // The unified cgroup v2 hierarchy.
+                forEachCgroupDirectory( mCgroupRoot, cgroupPath, [this, &quota]( const std::string& directory ) {
+                    keepSmallest( quota, readCgroupV2Quota( directory ) );
+                } );
+                continue;
+            }
+
+            std::vector<std::string> controllerList;
+            std::istringstream controllerStream( controllers );
+            std::string controller;
+            while( std::getline( controllerStream, controller, ',' ) )
+            {
+                controllerList.push_back( controller );
+            }
+            if( std::find( controllerList.begin(), controllerList.end(), "cpu" ) == controllerList.end() )
+            {
+                continue;
+            }
+
+            // The cgroup v1 cpu controller is mounted either by its full controller list or by
+            // the plain controller name.
+            for( const std::string& mountName : { controllers, std::string( "cpu" ) } )
+            {
+                forEachCgroupDirectory( mCgroupRoot + "/" + mountName, cgroupPath,
+                                        [this, &quota]( const std::string& directory ) {
+                                            keepSmallest( quota, readCgroupV1Quota( directory ) );
+                                        } );
+            }
+        }
+        return quota;
+    }
+
+    size_t SystemResources::getNumberOfAffinityCpus() const
+    {
+#if defined( __linux__ )
+        cpu_set_t cpuSet;
+        CPU_ZERO( &cpuSet );
+        if( ::sched_getaffinity( 0, sizeof( cpuSet ), &cpuSet ) == 0 )
+        {
+            int count = CPU_COUNT( &cpuSet );
+            if( count > 0 )
+            {
+                return static_cast<size_t>( count );
+            }
+        }
+#endif
+        return std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+    }
+
+    size_t SystemResources::getNumberOfAvailableCpus() const
+    {
+        size_t numCpus = getNumberOfAffinityCpus();
+        auto quota = getCpuQuota();
+        if( quota.has_value() )
+        {
+            numCpus = std::min( numCpus, static_cast<size_t>( std::ceil( quota.value() ) ) );
+        }
+        return std::max<size_t>( numCpus, 1 );
+    }
+
+    std::optional<double> SystemResources::readCgroupV2Quota( const std::string& directory ) const
+    {
+        // The file has the quota and the period in microseconds, or "max" for no quota.
+        std::ifstream cpuMaxFile( directory + "/cpu.max" );
+        std::string quota;
+        double period = 0.0;
+        if( !( cpuMaxFile >> quota >> period ) || quota == "max" || period <= 0.0 )
+        {
+            return std::nullopt;
+        }
+        try
+        {
+            double quotaValue = std::stod( quota );
+            if( quotaValue <= 0.0 )
+            {
+                return std::nullopt;
+            }
+            return quotaValue / period;
+        }
+        catch( const std::exception& )
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<double> SystemResources::readCgroupV1Quota( const std::string& directory ) const
+    {
+        // The quota is -1 when there is no quota.
+        std::ifstream quotaFile( directory + "/cpu.cfs_quota_us" );
+        std::ifstream periodFile( directory + "/cpu.cfs_period_us" );
+        double quota = 0.0;
+        double period = 0.0;
+        if( !( quotaFile >> quota ) || !( periodFile >> period ) || quota <= 0.0 || period <= 0.0 )
+        {
+            return std::nullopt;
+        }
+        return quota / period;
+    }
+
+}  // namespace threadpooluniverse
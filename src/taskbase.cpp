@@ -39,9 +39,29 @@ namespace threadpooluniverse
         return mCanceled.load();
     }
 
+    void TaskBase::setDeadline( std::optional<Clock::time_point> deadline )
+    {
+        mDeadline = deadline;
+    }
+
+    std::optional<TaskBase::Clock::time_point> TaskBase::getDeadline() const
+    {
+        return mDeadline;
+    }
+
+    bool TaskBase::isExpired( Clock::time_point now ) const
+    {
+        return mDeadline.has_value() && mDeadline.value() < now;
+    }
+
     void TaskBase::handleError()
     {
         // Default implementation does nothing.
     }
 
+    void TaskBase::handleExpired()
+    {
+        // Default implementation does nothing.
+    }
+
 }  // namespace threadpooluniverse
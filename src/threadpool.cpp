@@ -6,15 +6,53 @@
  */
 
 #include "../include/threadpool.h"
+#include "../include/serializabletask.h"
+#include "../include/systemresources.h"
 #include "../include/threadpoolexceptions.h"
 #include "../include/taskbase.h"
+#include "keyedtask.h"
+#include "spillfile.h"
 #include "workerthread.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
 namespace threadpooluniverse
 {
-    ThreadPool::ThreadPool( size_t numOfThreads, const std::optional<size_t> maxQueueSize ) :
+    namespace
+    {
+        /**
+         * Maximum number of tasks a worker thread takes from the queue at once.
+         */
+        const size_t kMaxTaskBatchSize = 16;
+
+        /**
+         * Returns true if task 'a' should be executed before task 'b' in earliest-deadline-first
+         * order. Tasks without deadline are considered to have infinitely distant deadline.
+         */
+        bool hasEarlierDeadline( const std::unique_ptr<TaskBase>& a, const std::unique_ptr<TaskBase>& b )
+        {
+            auto deadlineA = a->getDeadline();
+            auto deadlineB = b->getDeadline();
+            if( !deadlineA.has_value() )
+            {
+                return false;
+            }
+            return !deadlineB.has_value() || deadlineA.value() < deadlineB.value();
+        }
+    }  // namespace
+
+    ThreadPool::ThreadPool( size_t numOfThreads, const std::optional<size_t> maxQueueSize,
+                            WorkerStartup workerStartup ) :
         mMaxQueueSize( maxQueueSize ),
         mNumberOfThreads( numOfThreads ),
+        mWorkerStartup( workerStartup ),
+        mMaxCompensatingThreads( numOfThreads ),
+        mNumberOfBlockedWorkers( 0 ),
+        mScratchArenaReset( ScratchArenaReset::AfterEachTask ),
         mStarted( false ),
         mNumberOfTasksInExecution( 0 )
     {
@@ -45,25 +83,239 @@ namespace threadpooluniverse
     }
 
     void ThreadPool::pushToQueue( std::unique_ptr<TaskBase> task )
+    {
+        const char* rejectReason = enqueueTask( task );
+        if( rejectReason != nullptr )
+        {
+            throw TaskQueueFullException( rejectReason );
+        }
+    }
+
+    std::unique_ptr<TaskBase> ThreadPool::tryPushToQueue( std::unique_ptr<TaskBase> task )
+    {
+        if( enqueueTask( task ) != nullptr )
+        {
+            return task;
+        }
+        return nullptr;
+    }
+
+    uint64_t ThreadPool::pushToQueue( std::unique_ptr<TaskBase> task, const std::string& key,
+                                      CoalescePolicy policy, MergeCallback mergeCallback )
+    {
+        // Declared before the lock so that the discarded task gets destroyed after unlocking.
+        std::unique_ptr<TaskBase> discardedTask;
+        std::unique_ptr<TaskBase> keyedTask;
+        KeyedTask* publishedTask = nullptr;
+        {
+            std::unique_lock<std::mutex> lock( mKeyedTasksMutex );
+            auto it = mKeyedTasks.find( key );
+            while( it != mKeyedTasks.end() && it->second->mPushing )
+            {
+                // The task of the key may still get rejected by the queue. Wait for the outcome so
+                // that this task does not get coalesced with a task that never gets queued.
+                mKeyedTasksCV.wait( lock );
+                it = mKeyedTasks.find( key );
+            }
+            if( it != mKeyedTasks.end() )
+            {
+                KeyedTask& queuedTask = *it->second;
+                if( policy == CoalescePolicy::KeepLast )
+                {
+                    discardedTask = std::move( queuedTask.mTask );
+                    queuedTask.mTask = std::move( task );
+                }
+                else if( policy == CoalescePolicy::Merge && mergeCallback )
+                {
+                    mergeCallback( *queuedTask.mTask, std::move( task ) );
+                }
+                else
+                {
+                    discardedTask = std::move( task );
+                }
+                ++mNumberOfCoalescedTasks;
+                return queuedTask.getTaskId();
+            }
+
+            auto newTask = std::make_unique<KeyedTask>( *this, key, std::move( task ) );
+            publishedTask = newTask.get();
+            mKeyedTasks.emplace( key, publishedTask );
+            keyedTask = std::move( newTask );
+        }
+
+        uint64_t taskId = keyedTask->getTaskId();
+        const char* rejectReason = enqueueTask( keyedTask );
+        {
+            std::lock_guard<std::mutex> lock( mKeyedTasksMutex );
+            // A worker may have taken the task already, in which case the key is gone.
+            auto it = mKeyedTasks.find( key );
+            if( it != mKeyedTasks.end() && it->second == publishedTask )
+            {
+                if( rejectReason != nullptr )
+                {
+                    mKeyedTasks.erase( it );
+                }
+                else
+                {
+                    publishedTask->mPushing = false;
+                }
+            }
+        }
+        mKeyedTasksCV.notify_all();
+
+        if( rejectReason != nullptr )
+        {
+            // The rejected keyed task gets destroyed when the exception unwinds this function.
+            throw TaskQueueFullException( rejectReason );
+        }
+        return taskId;
+    }
+
+    size_t ThreadPool::getNumberOfCoalescedTasks()
+    {
+        std::lock_guard<std::mutex> lock( mKeyedTasksMutex );
+        return mNumberOfCoalescedTasks;
+    }
+
+    void ThreadPool::setSchedulingPolicy( SchedulingPolicy policy )
     {
         std::lock_guard<std::mutex> lock( mTasksMutex );
-        if( mMaxQueueSize.has_value() && mTasks.size() >= mMaxQueueSize.value() )
+        mSchedulingPolicy = policy;
+        if( mSchedulingPolicy == SchedulingPolicy::EarliestDeadlineFirst )
+        {
+            // The list sort is stable so tasks having equal deadlines keep their FIFO order.
+            mTasks.sort( hasEarlierDeadline );
+        }
+        else
         {
-            // Queue is full, we cannot add more tasks.
-            throw TaskQueueFullException( "Task queue full." );
+            // Restore the order in which the tasks were pushed.
+            mTasks.sort( []( const std::unique_ptr<TaskBase>& a, const std::unique_ptr<TaskBase>& b ) {
+                return a->mQueueSequence < b->mQueueSequence;
+            } );
         }
-        mTasks.push_back( std::move( task ) );
-        mTasksCV.notify_one();
+    }
+
+    void ThreadPool::setExpiryPolicy( ExpiryPolicy policy )
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        mExpiryPolicy = policy;
+    }
+
+    size_t ThreadPool::getNumberOfExpiredTasks()
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        return mNumberOfExpiredTasks;
+    }
+
+    void ThreadPool::setWorkerHooks( WorkerHook initHook, WorkerHook teardownHook )
+    {
+        std::lock_guard<std::mutex> lock( mWorkersMutex );
+        mWorkerInitHook = std::move( initHook );
+        mWorkerTeardownHook = std::move( teardownHook );
+    }
+
+    void ThreadPool::setScratchArenaReset( ScratchArenaReset reset )
+    {
+        mScratchArenaReset.store( reset );
+    }
+
+    ScratchArena* ThreadPool::getCurrentScratchArena()
+    {
+        WorkerThread* worker = WorkerThread::current();
+        return worker != nullptr ? &worker->accessScratchArena() : nullptr;
+    }
+
+    void ThreadPool::setAdmissionControl( std::optional<AdmissionControlSettings> settings )
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        mAdmissionControl = settings;
+        mAboveTargetDelayUntil.reset();
+        mOverloaded = false;
+    }
+
+    bool ThreadPool::isOverloaded()
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        return mOverloaded;
+    }
+
+    size_t ThreadPool::getNumberOfRejectedTasks()
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        return mNumberOfRejectedTasks;
+    }
+
+    void ThreadPool::setSpill( std::optional<SpillSettings> settings )
+    {
+        std::unique_lock<std::mutex> lock( mTasksMutex );
+        if( settings.has_value() )
+        {
+            if( !settings->deserializer )
+            {
+                throw std::invalid_argument( "Spill settings have no deserializer." );
+            }
+            if( !mSpillFile )
+            {
+                mSpillFile = std::make_unique<SpillFile>( settings->directory );
+            }
+            mSpillSettings = std::move( settings );
+            mDisablingSpill = false;
+            return;
+        }
+
+        if( mSpillFile )
+        {
+            // No new tasks get spilled because of the high-water mark. The tasks pushed while
+            // the spill file still has records go there so that they stay behind the spilled ones.
+            mDisablingSpill = true;
+            while( countSpilledTasks() > 0 )
+            {
+                if( mRestoringSpill )
+                {
+                    // Wait for the worker thread that is restoring the tasks.
+                    lock.unlock();
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                    lock.lock();
+                    continue;
+                }
+                refillFromSpill( lock, std::numeric_limits<size_t>::max() );
+            }
+            mSpillFile.reset();
+            mDisablingSpill = false;
+        }
+        mSpillSettings.reset();
+    }
+
+    size_t ThreadPool::getNumberOfSpilledTasks()
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        return countSpilledTasks();
     }
 
     void ThreadPool::clearQueue()
     {
         std::lock_guard<std::mutex> lock( mTasksMutex );
         mTasks.clear();
+        if( mSpillFile )
+        {
+            mSpillFile->clear();
+        }
+        // The tasks that a worker thread is restoring from the spill file get dropped too.
+        ++mSpillGeneration;
+
+        std::lock_guard<std::mutex> workersLock( mWorkersMutex );
+        for( auto& worker : mWorkers )
+        {
+            std::lock_guard<std::mutex> batchLock( worker->mBatchMutex );
+            mNumberOfTasksInExecution -= worker->mBatch.size();
+            worker->mBatch.clear();
+        }
     }
 
     bool ThreadPool::cancelTask( uint64_t taskId )
     {
+        // The tasks mutex is held while going through the batches because tasks move from
+        // queue to the batches only under it.
         std::lock_guard<std::mutex> lock( mTasksMutex );
         for( auto it = mTasks.begin(); it != mTasks.end(); ++it )
         {
@@ -74,18 +326,40 @@ namespace threadpooluniverse
                 return true;
             }
         }
+        if( mSpillFile && mSpillFile->remove( taskId ) )
+        {
+            return true;
+        }
+
+        std::lock_guard<std::mutex> workersLock( mWorkersMutex );
+        for( auto& worker : mWorkers )
+        {
+            std::lock_guard<std::mutex> batchLock( worker->mBatchMutex );
+            auto& batch = worker->mBatch;
+            for( auto it = batch.begin(); it != batch.end(); ++it )
+            {
+                if( ( *it )->getTaskId() == taskId )
+                {
+                    ( *it )->cancel();
+                    batch.erase( it );
+                    --mNumberOfTasksInExecution;
+                    return true;
+                }
+            }
+        }
         return false;
     }
 
     size_t ThreadPool::getNumberOfTasks()
     {
         std::lock_guard<std::mutex> lock( mTasksMutex );
-        size_t numTasksInQueue = mTasks.size();
+        size_t numTasksInQueue = mTasks.size() + countSpilledTasks();
         return numTasksInQueue + mNumberOfTasksInExecution.load();;
     }
 
     size_t ThreadPool::getNumberOfIdleThreads()
     {
+        std::lock_guard<std::mutex> lock( mWorkersMutex );
         size_t numIdleThreads = 0;
         for( auto& worker : mWorkers )
         {
@@ -97,12 +371,52 @@ namespace threadpooluniverse
         return numIdleThreads;
     }
 
+    void ThreadPool::setMaxCompensatingThreads( size_t maxCompensatingThreads )
+    {
+        mMaxCompensatingThreads.store( maxCompensatingThreads );
+    }
+
+    size_t ThreadPool::getNumberOfCompensatingThreads()
+    {
+        std::lock_guard<std::mutex> lock( mWorkersMutex );
+        return mCompensatingWorkers.size();
+    }
+
+    size_t ThreadPool::getNumberOfRunningThreads()
+    {
+        std::lock_guard<std::mutex> lock( mWorkersMutex );
+        return mNumberOfRunningWorkerThreads;
+    }
+
+    std::optional<size_t> ThreadPool::getCurrentWorkerIndex()
+    {
+        WorkerThread* worker = WorkerThread::current();
+        if( worker == nullptr || &worker->accessOwningThreadPool() != this )
+        {
+            return std::nullopt;
+        }
+        return worker->getIndex();
+    }
+
     bool ThreadPool::allThreadsRunning()
     {
         std::lock_guard<std::mutex> lock( mWorkersMutex );
         return mNumberOfRunningWorkerThreads == mNumberOfThreads;
     }
 
+    size_t ThreadPool::getDefaultNumberOfThreads()
+    {
+        return SystemResources().getNumberOfAvailableCpus();
+    }
+
+    ThreadPool& ThreadPool::getSharedDefault()
+    {
+        static ThreadPool sharedDefault( getDefaultNumberOfThreads(), std::nullopt );
+        static std::once_flag startFlag;
+        std::call_once( startFlag, []() { sharedDefault.startProcessing(); } );
+        return sharedDefault;
+    }
+
     size_t ThreadPool::getNumberOfThreads()
     {
         return mNumberOfThreads;
@@ -118,59 +432,289 @@ namespace threadpooluniverse
 
     void ThreadPool::startWorkers()
     {
-        for( size_t i = 0; i < mNumberOfThreads; ++i )
+        if( mWorkerStartup == WorkerStartup::Lazy )
+        {
+            // Workers get created when the tasks are pushed to the queue.
+            return;
+        }
+
         {
-            mWorkers.emplace_back( std::make_unique<WorkerThread>( *this ) );
+            std::lock_guard<std::mutex> lock( mWorkersMutex );
+            for( size_t i = 0; i < mNumberOfThreads; ++i )
+            {
+                mWorkers.emplace_back( std::make_unique<WorkerThread>( *this, i ) );
+            }
+        }
+
+        if( mWorkerStartup == WorkerStartup::Eager )
+        {
+            // Wait until all worker threads are running.
+            while( allThreadsRunning() == false )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 0 ) );
+            }
         }
+    }
 
-        // Wait until all worker threads are running.
-        while( allThreadsRunning() == false )
+    void ThreadPool::startWorkerOnDemand( size_t numQueuedTasks )
+    {
+        std::lock_guard<std::mutex> lock( mWorkersMutex );
+        if( mWorkersShutdown || mWorkers.size() >= mNumberOfThreads )
+        {
+            return;
+        }
+        size_t numIdleThreads = 0;
+        for( auto& worker : mWorkers )
+        {
+            if( worker->isIdle() )
+            {
+                ++numIdleThreads;
+            }
+        }
+        if( numQueuedTasks > numIdleThreads )
         {
-            std::this_thread::sleep_for( std::chrono::milliseconds( 0 ) );
+            mWorkers.emplace_back( std::make_unique<WorkerThread>( *this, mWorkers.size() ) );
         }
     }
 
     void ThreadPool::shutdownWorkers()
     {
+        // Take the workers so that no new workers get created during the shutdown. The mutex
+        // cannot be held while joining because starting worker threads need it.
+        std::vector<std::unique_ptr<WorkerThread>> workers;
+        {
+            std::lock_guard<std::mutex> lock( mWorkersMutex );
+            mWorkersShutdown = true;
+            workers.swap( mWorkers );
+            for( auto& compensatingWorker : mCompensatingWorkers )
+            {
+                workers.push_back( std::move( compensatingWorker ) );
+            }
+            mCompensatingWorkers.clear();
+        }
+
         // Ask worker threads to exit.
-        for( auto& worker : mWorkers )
+        for( auto& worker : workers )
         {
             worker->requestExit();
         }
 
         // Wake up all worker threads to process exit request.
-        mTasksCV.notify_all();
+        {
+            std::lock_guard<std::mutex> lock( mTasksMutex );
+            mTasksCV.notify_all();
+            mCompensationCV.notify_all();
+        }
 
         // Join all worker threads.
-        for( auto& worker : mWorkers )
+        for( auto& worker : workers )
         {
             if( worker->accessThread().joinable() )
             {
                 worker->accessThread().join();
             }
         }
-        mWorkers.clear();
     }
 
-    std::unique_ptr<TaskBase> ThreadPool::getTaskForProcessing()
+    std::unique_ptr<TaskBase> ThreadPool::getTaskForProcessing( WorkerThread& worker )
     {
         // Return null task if task processing not started.
         if( !mStarted.load() )
         {
+            returnBatchToQueue( worker );
             return nullptr;
         }
 
-        // Get the next task from the queue.
-        std::lock_guard<std::mutex> lock( mTasksMutex );
-        if( mTasks.empty() )
+        // Compensating workers take tasks only while other workers are blocked.
+        if( worker.isCompensating() && !isCompensationActive( worker ) )
         {
             return nullptr;
         }
-        std::unique_ptr<TaskBase> task = std::move( mTasks.front() );
-        mTasks.pop_front();
 
-        ++mNumberOfTasksInExecution;
-        return std::move( task );
+        // Process the tasks that were taken in the previous batch first. They have already been
+        // counted to be in execution.
+        while( true )
+        {
+            std::unique_ptr<TaskBase> task;
+            {
+                std::lock_guard<std::mutex> batchLock( worker.mBatchMutex );
+                if( worker.mBatch.empty() )
+                {
+                    break;
+                }
+                task = std::move( worker.mBatch.front() );
+                worker.mBatch.pop_front();
+            }
+            if( !dropIfExpired( task ) )
+            {
+                return task;
+            }
+        }
+
+        // Get the next batch of tasks from the queue. Expired tasks are taken out from the queue
+        // as well when they are to be dropped.
+        std::unique_ptr<TaskBase> task;
+        std::vector<std::unique_ptr<TaskBase>> expiredTasks;
+        {
+            std::unique_lock<std::mutex> lock( mTasksMutex );
+            if( mSpillFile )
+            {
+                refillFromSpill( lock, mSpillSettings->highWaterMark );
+            }
+            const bool dropExpired = mExpiryPolicy == ExpiryPolicy::DropExpired;
+            const bool needsTime = dropExpired || mAdmissionControl.has_value();
+            const auto now = needsTime ? TaskBase::Clock::now() : TaskBase::Clock::time_point();
+
+            // Take at most half of this worker's fair share so that the other workers still
+            // find tasks in the queue.
+            size_t batchSize = mTasks.size() / ( 2 * std::max<size_t>( mNumberOfThreads, 1 ) );
+            batchSize = std::min( std::max<size_t>( batchSize, 1 ), kMaxTaskBatchSize );
+            if( worker.isCompensating() )
+            {
+                // Compensating workers may retire after any task so they don't take batches.
+                batchSize = 1;
+            }
+            if( needsTime || mSchedulingPolicy == SchedulingPolicy::EarliestDeadlineFirst )
+            {
+                // Expiry, deadline order and sojourn times are decided when a task leaves the
+                // queue so the tasks are not taken in batches.
+                batchSize = 1;
+            }
+
+            std::lock_guard<std::mutex> batchLock( worker.mBatchMutex );
+            size_t numTaken = 0;
+            while( !mTasks.empty() && numTaken < batchSize )
+            {
+                std::unique_ptr<TaskBase> candidate = std::move( mTasks.front() );
+                mTasks.pop_front();
+                updateAdmissionControl( *candidate, now );
+                if( dropExpired && candidate->isExpired( now ) )
+                {
+                    expiredTasks.push_back( std::move( candidate ) );
+                    continue;
+                }
+                if( task )
+                {
+                    worker.mBatch.push_back( std::move( candidate ) );
+                }
+                else
+                {
+                    task = std::move( candidate );
+                }
+                ++mNumberOfTasksInExecution;
+                ++numTaken;
+            }
+
+            // Expired tasks count as in execution until their expiry handlers have been run so
+            // that 'waitAllTasks()' does not return too early.
+            mNumberOfExpiredTasks += expiredTasks.size();
+            mNumberOfTasksInExecution += expiredTasks.size();
+        }
+
+        if( !expiredTasks.empty() )
+        {
+            for( auto& expiredTask : expiredTasks )
+            {
+                try
+                {
+                    expiredTask->handleExpired();
+                }
+                catch( const std::exception& )
+                {
+                    // Handle expired threw an exception. Ignore it like errors from 'handleError()'.
+                }
+            }
+            std::lock_guard<std::mutex> lock( mTasksMutex );
+            mNumberOfTasksInExecution -= expiredTasks.size();
+        }
+
+        while( !task )
+        {
+            task = stealTaskFromOtherWorker( worker );
+            if( !task )
+            {
+                break;
+            }
+            if( dropIfExpired( task ) )
+            {
+                task.reset();
+            }
+        }
+        return task;
+    }
+
+    bool ThreadPool::dropIfExpired( std::unique_ptr<TaskBase>& task )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mTasksMutex );
+            if( mExpiryPolicy != ExpiryPolicy::DropExpired
+                || !task->isExpired( TaskBase::Clock::now() ) )
+            {
+                return false;
+            }
+            // The task is already counted in execution so only the expired count is updated.
+            ++mNumberOfExpiredTasks;
+        }
+
+        try
+        {
+            task->handleExpired();
+        }
+        catch( const std::exception& )
+        {
+            // Handle expired threw an exception. Ignore it like errors from 'handleError()'.
+        }
+        task.reset();
+
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        --mNumberOfTasksInExecution;
+        return true;
+    }
+
+    std::unique_ptr<TaskBase> ThreadPool::stealTaskFromOtherWorker( WorkerThread& worker )
+    {
+        std::lock_guard<std::mutex> workersLock( mWorkersMutex );
+        for( auto& otherWorker : mWorkers )
+        {
+            if( otherWorker.get() == &worker )
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> batchLock( otherWorker->mBatchMutex );
+            if( !otherWorker->mBatch.empty() )
+            {
+                // Steal from the back because the owner takes from the front.
+                std::unique_ptr<TaskBase> task = std::move( otherWorker->mBatch.back() );
+                otherWorker->mBatch.pop_back();
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void ThreadPool::returnBatchToQueue( WorkerThread& worker )
+    {
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        std::lock_guard<std::mutex> batchLock( worker.mBatchMutex );
+        if( worker.mBatch.empty() )
+        {
+            return;
+        }
+        mNumberOfTasksInExecution -= worker.mBatch.size();
+        if( mSchedulingPolicy == SchedulingPolicy::Fifo )
+        {
+            // The batch was taken from the front of the queue so put it back there.
+            mTasks.insert( mTasks.begin(), std::make_move_iterator( worker.mBatch.begin() ),
+                           std::make_move_iterator( worker.mBatch.end() ) );
+        }
+        else
+        {
+            for( auto& task : worker.mBatch )
+            {
+                insertToQueue( std::move( task ) );
+            }
+        }
+        worker.mBatch.clear();
     }
 
     void ThreadPool::taskCompleted()
@@ -179,19 +723,388 @@ namespace threadpooluniverse
         --mNumberOfTasksInExecution;
     }
 
-    void ThreadPool::waitForNotify()
+    void ThreadPool::waitForNotify( WorkerThread& worker )
     {
         // Wait for new tasks to be added to the queue or for a timeout. The timeout is used to
         // avoid apparent glitches the condition variable seems to have. When notify_all() is called, it
         // seems that always not every thread wakes although they are waiting on the same condition variable.
         std::unique_lock<std::mutex> lock( mTasksMutex );
+        if( worker.isCompensating() && !isCompensationActive( worker ) )
+        {
+            // Retired compensating workers wait on their own condition variable so that they
+            // don't consume the notifications meant for the workers that take the tasks.
+            mCompensationCV.wait_for( lock, std::chrono::seconds( 1 ),
+                                      [this, &worker]() { return isCompensationActive( worker ); } );
+            return;
+        }
         mTasksCV.wait_for( lock, std::chrono::seconds( 1 ) );
     }
 
-    void ThreadPool::registerRunningWorkerThread()
+    void ThreadPool::registerRunningWorkerThread( WorkerThread& worker )
     {
         std::lock_guard<std::mutex> lock( mWorkersMutex );
-        ++mNumberOfRunningWorkerThreads;
+        if( !worker.isCompensating() )
+        {
+            ++mNumberOfRunningWorkerThreads;
+        }
+    }
+
+    bool ThreadPool::isProcessingStarted() const
+    {
+        return mStarted.load();
+    }
+
+    void ThreadPool::workerInitialize( WorkerThread& worker )
+    {
+        WorkerHook initHook;
+        {
+            std::lock_guard<std::mutex> lock( mWorkersMutex );
+            initHook = mWorkerInitHook;
+        }
+        if( initHook )
+        {
+            try
+            {
+                initHook( worker.getIndex() );
+            }
+            catch( const std::exception& )
+            {
+                // Don't let exceptions terminate the worker thread.
+            }
+        }
+    }
+
+    void ThreadPool::workerTeardown( WorkerThread& worker )
+    {
+        WorkerHook teardownHook;
+        {
+            std::lock_guard<std::mutex> lock( mWorkersMutex );
+            teardownHook = mWorkerTeardownHook;
+        }
+        if( teardownHook )
+        {
+            try
+            {
+                teardownHook( worker.getIndex() );
+            }
+            catch( const std::exception& )
+            {
+                // Don't let exceptions terminate the worker thread.
+            }
+        }
+    }
+
+    void ThreadPool::workerTaskFinished( WorkerThread& worker )
+    {
+        if( mScratchArenaReset.load() == ScratchArenaReset::AfterEachTask )
+        {
+            worker.accessScratchArena().reset();
+        }
+    }
+
+    std::unique_ptr<TaskBase> ThreadPool::takeKeyedTask( KeyedTask& keyedTask )
+    {
+        std::lock_guard<std::mutex> lock( mKeyedTasksMutex );
+        auto it = mKeyedTasks.find( keyedTask.getKey() );
+        if( it != mKeyedTasks.end() && it->second == &keyedTask )
+        {
+            mKeyedTasks.erase( it );
+            if( keyedTask.mPushing )
+            {
+                // A worker took the task before the push returned. Wake up the waiting pushers.
+                mKeyedTasksCV.notify_all();
+            }
+        }
+        return std::move( keyedTask.mTask );
+    }
+
+    void ThreadPool::beginBlocking()
+    {
+        size_t numBlockedWorkers = ++mNumberOfBlockedWorkers;
+        {
+            std::lock_guard<std::mutex> lock( mWorkersMutex );
+            size_t numNeeded = std::min( numBlockedWorkers, mMaxCompensatingThreads.load() );
+            if( !mWorkersShutdown && mCompensatingWorkers.size() < numNeeded )
+            {
+                size_t index = mNumberOfThreads + mCompensatingWorkers.size();
+                mCompensatingWorkers.emplace_back( std::make_unique<WorkerThread>( *this, index, true ) );
+            }
+        }
+
+        // Wake up the retired compensating workers.
+        std::lock_guard<std::mutex> lock( mTasksMutex );
+        mCompensationCV.notify_all();
+    }
+
+    void ThreadPool::endBlocking()
+    {
+        --mNumberOfBlockedWorkers;
+    }
+
+    bool ThreadPool::isCompensationActive( const WorkerThread& worker ) const
+    {
+        size_t compensationSlot = worker.getIndex() - mNumberOfThreads;
+        size_t numActive = std::min( mNumberOfBlockedWorkers.load(), mMaxCompensatingThreads.load() );
+        return compensationSlot < numActive;
+    }
+
+    ThreadPool::BlockingScope::BlockingScope() :
+        mWorker( WorkerThread::current() )
+    {
+        if( mWorker != nullptr && mWorker->mBlockingScopeDepth++ == 0 )
+        {
+            mWorker->accessOwningThreadPool().beginBlocking();
+        }
+    }
+
+    ThreadPool::BlockingScope::~BlockingScope()
+    {
+        if( mWorker != nullptr && --mWorker->mBlockingScopeDepth == 0 )
+        {
+            mWorker->accessOwningThreadPool().endBlocking();
+        }
+    }
+
+    void ThreadPool::updateAdmissionControl( const TaskBase& task,
+                                             std::chrono::steady_clock::time_point now )
+    {
+        if( !mAdmissionControl.has_value() )
+        {
+            return;
+        }
+
+        // The pool is overloaded when the queueing delay has stayed above the target for a whole
+        // interval. A single delay below the target or an empty queue ends the overload.
+        auto sojournTime = now - task.mQueuedTime;
+        if( sojournTime < mAdmissionControl->targetDelay || mTasks.empty() )
+        {
+            mAboveTargetDelayUntil.reset();
+            mOverloaded = false;
+        }
+        else if( !mAboveTargetDelayUntil.has_value() )
+        {
+            mAboveTargetDelayUntil = now + mAdmissionControl->interval;
+        }
+        else if( now >= mAboveTargetDelayUntil.value() )
+        {
+            mOverloaded = true;
+        }
+    }
+
+    const char* ThreadPool::enqueueTask( std::unique_ptr<TaskBase>& task )
+    {
+        task->mQueuedTime = TaskBase::Clock::now();
+        size_t numQueuedTasks = 0;
+        std::vector<char> spillData;
+        // Declared before the lock so that the spilled task gets destroyed after unlocking.
+        std::unique_ptr<TaskBase> spilledTask;
+        {
+            std::unique_lock<std::mutex> lock( mTasksMutex );
+            bool spill = false;
+            if( shouldSpill( *task ) )
+            {
+                // Serialize without holding the lock because 'serialize()' is user code.
+                lock.unlock();
+                spill = serializeForSpill( *task, spillData );
+                lock.lock();
+            }
+            const bool queueFull = mMaxQueueSize.has_value() && mTasks.size() >= mMaxQueueSize.value();
+            if( !spill && queueFull )
+            {
+                // Queue is full, we cannot add more tasks.
+                return "Task queue full.";
+            }
+            if( mOverloaded && !mTasks.empty() )
+            {
+                // Tasks have been waiting too long in the queue. An empty queue has no queueing
+                // delay so it always accepts a task.
+                ++mNumberOfRejectedTasks;
+                return "Task queue delay above target.";
+            }
+            if( spill && spillTask( *task, spillData ) )
+            {
+                spilledTask = std::move( task );
+            }
+            else if( queueFull )
+            {
+                // The task could not be spilled so the queue limit applies to it.
+                return "Task queue full.";
+            }
+            else
+            {
+                task->mQueueSequence = ++mQueueSequenceCounter;
+                insertToQueue( std::move( task ) );
+            }
+            numQueuedTasks = mTasks.size() + countSpilledTasks();
+            mTasksCV.notify_one();
+        }
+        if( mWorkerStartup == WorkerStartup::Lazy )
+        {
+            startWorkerOnDemand( numQueuedTasks );
+        }
+        return nullptr;
+    }
+
+    bool ThreadPool::shouldSpill( const TaskBase& task ) const
+    {
+        if( !mSpillFile || dynamic_cast<const SerializableTask*>( &task ) == nullptr )
+        {
+            return false;
+        }
+        if( task.getDeadline().has_value() )
+        {
+            // The spilled tasks are not ordered by deadline or checked for expiry until they
+            // are read back, so the tasks with a deadline stay in the queue.
+            return false;
+        }
+        // Once tasks have been spilled, the following serializable tasks go to the spill file
+        // too so that they are not executed before the spilled ones.
+        if( countSpilledTasks() > 0 )
+        {
+            return true;
+        }
+        return !mDisablingSpill && mTasks.size() >= mSpillSettings->highWaterMark;
+    }
+
+    bool ThreadPool::serializeForSpill( const TaskBase& task, std::vector<char>& data )
+    {
+        try
+        {
+            static_cast<const SerializableTask&>( task ).serialize( data );
+            return true;
+        }
+        catch( ... )
+        {
+            // The task is kept in memory instead.
+            return false;
+        }
+    }
+
+    bool ThreadPool::spillTask( const TaskBase& task, const std::vector<char>& data )
+    {
+        if( !mSpillFile )
+        {
+            // The spill was disabled while the task was being serialized.
+            return false;
+        }
+        try
+        {
+            mSpillFile->append( task.getTaskId(), task.mQueuedTime, task.getDeadline(), data );
+            return true;
+        }
+        catch( const std::system_error& )
+        {
+            // The spill file cannot grow. The task is kept in memory instead.
+            return false;
+        }
+        catch( const std::length_error& )
+        {
+            // The serialized task is too big for a spill record. The task is kept in memory instead.
+            return false;
+        }
+    }
+
+    void ThreadPool::refillFromSpill( std::unique_lock<std::mutex>& lock, size_t highWaterMark )
+    {
+        if( mRestoringSpill )
+        {
+            // Restoring in parallel could reorder the tasks.
+            return;
+        }
+
+        // Read at least one task so that the spilled tasks get processed with zero high-water
+        // mark too.
+        highWaterMark = std::max<size_t>( highWaterMark, 1 );
+        std::vector<SpillFile::Record> records;
+        SpillFile::Record record;
+        while( mTasks.size() + records.size() < highWaterMark && mSpillFile->read( record ) )
+        {
+            records.push_back( std::move( record ) );
+        }
+        if( records.empty() )
+        {
+            return;
+        }
+
+        // Deserialize without holding the lock so that the deserializer may use the thread
+        // pool. The records being restored count as spilled tasks, so the serializable tasks
+        // pushed meanwhile go to the spill file behind them.
+        TaskDeserializer deserializer = mSpillSettings->deserializer;
+        const uint64_t generation = mSpillGeneration;
+        mRestoringSpill = true;
+        mNumberOfTasksBeingRestored = records.size();
+        lock.unlock();
+
+        std::vector<std::unique_ptr<TaskBase>> tasks;
+        tasks.reserve( records.size() );
+        for( auto& spilledRecord : records )
+        {
+            std::unique_ptr<TaskBase> task;
+            try
+            {
+                task = deserializer( spilledRecord.taskId, spilledRecord.data );
+            }
+            catch( ... )
+            {
+                // The task cannot be recreated so it is dropped.
+            }
+            if( !task )
+            {
+                continue;
+            }
+            if( spilledRecord.deadline.has_value() )
+            {
+                // Keep the deadline the deserializer may have given if the record has none.
+                task->setDeadline( spilledRecord.deadline );
+            }
+            task->mQueuedTime = spilledRecord.queuedTime;
+            tasks.push_back( std::move( task ) );
+        }
+
+        lock.lock();
+        mRestoringSpill = false;
+        mNumberOfTasksBeingRestored = 0;
+        if( generation != mSpillGeneration )
+        {
+            // The queue was cleared meanwhile. Destroy the tasks without holding the lock.
+            lock.unlock();
+            tasks.clear();
+            lock.lock();
+            return;
+        }
+        for( auto& task : tasks )
+        {
+            task->mQueueSequence = ++mQueueSequenceCounter;
+            insertToQueue( std::move( task ) );
+        }
+    }
+
+    size_t ThreadPool::countSpilledTasks() const
+    {
+        return ( mSpillFile ? mSpillFile->getNumberOfRecords() : 0 ) + mNumberOfTasksBeingRestored;
+    }
+
+    void ThreadPool::insertToQueue( std::unique_ptr<TaskBase> task )
+    {
+        if( mSchedulingPolicy == SchedulingPolicy::Fifo || !task->getDeadline().has_value() )
+        {
+            mTasks.push_back( std::move( task ) );
+            return;
+        }
+
+        // Search the insertion point from the end of the queue. New tasks usually have later
+        // deadlines than the queued ones so the search is typically short.
+        auto insertPos = mTasks.end();
+        while( insertPos != mTasks.begin() )
+        {
+            auto previous = std::prev( insertPos );
+            if( !hasEarlierDeadline( task, *previous ) )
+            {
+                break;
+            }
+            insertPos = previous;
+        }
+        mTasks.insert( insertPos, std::move( task ) );
     }
 
 }  // namespace threadpooluniverse
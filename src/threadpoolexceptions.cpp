@@ -24,4 +24,9 @@ namespace threadpooluniverse
     {
     }
 
+    TaskDroppedException::TaskDroppedException( const std::string& message )
+        : ThreadPoolBaseException( message )
+    {
+    }
+
 }  // namespace threadpooluniverse
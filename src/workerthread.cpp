@@ -11,9 +11,16 @@
 
 namespace threadpooluniverse
 {
-    WorkerThread::WorkerThread( ThreadPool& owningThreadPool ) :
+    namespace
+    {
+        thread_local WorkerThread* tCurrentWorker = nullptr;
+    }  // namespace
+
+    WorkerThread::WorkerThread( ThreadPool& owningThreadPool, size_t index, bool compensating ) :
         mOwningThreadPool( owningThreadPool ),
-        mIdle( true )
+        mIdle( true ),
+        mIndex( index ),
+        mCompensating( compensating )
     {
         mRequestExit.store( false );
         mWorkerThread = std::thread( &WorkerThread::threadFunction, this );
@@ -38,19 +45,53 @@ namespace threadpooluniverse
         return mIdle.load();
     }
 
+    size_t WorkerThread::getIndex() const
+    {
+        return mIndex;
+    }
+
+    bool WorkerThread::isCompensating() const
+    {
+        return mCompensating;
+    }
+
+    ScratchArena& WorkerThread::accessScratchArena()
+    {
+        return mScratchArena;
+    }
+
+    ThreadPool& WorkerThread::accessOwningThreadPool()
+    {
+        return mOwningThreadPool;
+    }
+
+    WorkerThread* WorkerThread::current()
+    {
+        return tCurrentWorker;
+    }
+
     void WorkerThread::threadFunction( WorkerThread* threadObject )
     {
+        tCurrentWorker = threadObject;
         threadObject->threadMain();
     }
 
     void WorkerThread::threadMain()
     {
-        mOwningThreadPool.registerRunningWorkerThread();
+        mOwningThreadPool.registerRunningWorkerThread( *this );
 
         // Main thread loop.
+        bool initialized = false;
         while( !mRequestExit.load() )
         {
-            auto task = mOwningThreadPool.getTaskForProcessing();
+            // The hooks are set after the constructor of the thread pool has started the
+            // workers, so the initialization waits until the processing gets started.
+            if( !initialized && mOwningThreadPool.isProcessingStarted() )
+            {
+                mOwningThreadPool.workerInitialize( *this );
+                initialized = true;
+            }
+            auto task = mOwningThreadPool.getTaskForProcessing( *this );
             if( task )
             {
                 mIdle.store( false );
@@ -71,14 +112,22 @@ namespace threadpooluniverse
                         // Handle error threw an exception. Ignore it for now.
                     }
                 }
+                mOwningThreadPool.workerTaskFinished( *this );
                 mOwningThreadPool.taskCompleted();
             }
             else
             {
                 mIdle.store( true );
-                mOwningThreadPool.waitForNotify();
+                mOwningThreadPool.waitForNotify( *this );
             }
         }
+
+        if( !initialized )
+        {
+            // The processing was never started. Keep the hooks paired anyway.
+            mOwningThreadPool.workerInitialize( *this );
+        }
+        mOwningThreadPool.workerTeardown( *this );
     }
 
 }  // namespace threadpooluniverse
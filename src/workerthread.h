@@ -8,12 +8,17 @@
 #ifndef THREADPOOLUNIVERSE_WORKERTHREAD_H
 #define THREADPOOLUNIVERSE_WORKERTHREAD_H
 
+#include "../include/scratcharena.h"
+
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 namespace threadpooluniverse
 {
+    class TaskBase;
     class ThreadPool;
 
     /**
@@ -22,7 +27,7 @@ namespace threadpooluniverse
     class WorkerThread
     {
     public:
-        WorkerThread(ThreadPool& owningThreadPool);
+        WorkerThread(ThreadPool& owningThreadPool, size_t index, bool compensating = false);
         ~WorkerThread();
 
         WorkerThread(const WorkerThread&) = delete;
@@ -34,6 +39,16 @@ namespace threadpooluniverse
         void requestExit();
         std::thread& accessThread();
         bool isIdle() const;
+        size_t getIndex() const;
+        bool isCompensating() const;
+        ScratchArena& accessScratchArena();
+        ThreadPool& accessOwningThreadPool();
+
+        /**
+         * Returns the worker thread object of the calling thread or nullptr if the calling
+         * thread is not a worker thread.
+         */
+        static WorkerThread* current();
 
     private:
         static void threadFunction( WorkerThread* threadObject );
@@ -42,8 +57,18 @@ namespace threadpooluniverse
     private:
         std::atomic_bool mRequestExit;
         std::atomic_bool mIdle;
+        size_t mIndex;
+        bool mCompensating;
+        size_t mBlockingScopeDepth{ 0 };
+        ScratchArena mScratchArena;
         ThreadPool& mOwningThreadPool;
         std::thread mWorkerThread;
+
+        // Tasks taken from the queue in a batch and waiting for execution by this worker.
+        std::deque<std::unique_ptr<TaskBase>> mBatch;
+        std::mutex mBatchMutex;
+
+        friend class ThreadPool;
     };
 }
 
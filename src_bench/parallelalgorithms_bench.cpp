@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "parallelalgorithms.h"
+#include "threadpool.h"
+
+using threadpooluniverse::ThreadPool;
+
+namespace
+{
+    const int kNumRepeats = 5;
+
+    /**
+     * Runs the function a few times and returns the fastest run in milliseconds. The setup
+     * function is called before each run and is not measured.
+     */
+    double measure( const std::function<void()>& setup, const std::function<void()>& function )
+    {
+        double best = 0.0;
+        for( int i = 0; i < kNumRepeats; ++i )
+        {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            function();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if( i == 0 || elapsed.count() < best )
+            {
+                best = elapsed.count();
+            }
+        }
+        return best;
+    }
+}  // namespace
+
+int main()
+{
+    const std::vector<size_t> sizes = { 100000, 1000000, 10000000 };
+    const std::vector<size_t> workerCounts = { 1, 2, 4, 8 };
+
+    std::printf( "%-10s %10s %8s %14s %14s %8s\n", "algorithm", "size", "workers", "std (ms)", "parallel (ms)",
+                 "speedup" );
+    for( size_t size : sizes )
+    {
+        std::mt19937 generator( 1 );
+        std::vector<uint64_t> input( size );
+        for( auto& value : input )
+        {
+            value = generator();
+        }
+        std::vector<uint64_t> values( size );
+        std::vector<uint64_t> sums( size );
+        auto copyInput = [&]() { values = input; };
+
+        double sortTime = measure( copyInput, [&]() { std::sort( values.begin(), values.end() ); } );
+        double scanTime =
+            measure( copyInput, [&]() { std::inclusive_scan( values.begin(), values.end(), sums.begin() ); } );
+
+        for( size_t workers : workerCounts )
+        {
+            ThreadPool threadPool( workers, std::nullopt );
+            threadPool.startProcessing();
+            double parallelSortTime = measure(
+                copyInput, [&]() { threadpooluniverse::parallelSort( threadPool, values.begin(), values.end() ); } );
+            double parallelScanTime = measure( copyInput, [&]() {
+                threadpooluniverse::parallelInclusiveScan( threadPool, values.begin(), values.end(), sums.begin() );
+            } );
+            threadPool.stopProcessing();
+
+            std::printf( "%-10s %10zu %8zu %14.2f %14.2f %8.2f\n", "sort", size, workers, sortTime,
+                         parallelSortTime, sortTime / parallelSortTime );
+            std::printf( "%-10s %10zu %8zu %14.2f %14.2f %8.2f\n", "scan", size, workers, scanTime,
+                         parallelScanTime, scanTime / parallelScanTime );
+        }
+    }
+    return 0;
+}
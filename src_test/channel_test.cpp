@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "callbacktask.h"
+#include "channel.h"
+#include "threadpool.h"
+
+using threadpooluniverse::Channel;
+using threadpooluniverse::ThreadPool;
+
+TEST( ChannelTest, TrySendAndReceive )
+{
+    ThreadPool threadPool( 1, std::nullopt );
+    Channel<std::unique_ptr<int>> channel( threadPool, 2 );
+    EXPECT_EQ( channel.getCapacity(), 2 );
+    EXPECT_FALSE( channel.tryReceive().has_value() );
+
+    auto first = std::make_unique<int>( 1 );
+    auto second = std::make_unique<int>( 2 );
+    auto third = std::make_unique<int>( 3 );
+    EXPECT_TRUE( channel.trySend( std::move( first ) ) );
+    EXPECT_TRUE( channel.trySend( std::move( second ) ) );
+    EXPECT_FALSE( channel.trySend( std::move( third ) ) );
+    ASSERT_NE( third, nullptr );  // Not moved from when the send fails.
+    EXPECT_EQ( channel.getSize(), 2 );
+
+    EXPECT_EQ( *channel.tryReceive().value(), 1 );
+    EXPECT_TRUE( channel.trySend( std::move( third ) ) );
+    EXPECT_EQ( *channel.tryReceive().value(), 2 );
+    EXPECT_EQ( *channel.tryReceive().value(), 3 );
+    EXPECT_EQ( channel.getSize(), 0 );
+
+    channel.close();
+    EXPECT_TRUE( channel.isClosed() );
+    EXPECT_FALSE( channel.trySend( std::make_unique<int>( 4 ) ) );
+}
+
+TEST( ChannelTest, ParkedContinuationsRunAsTasks )
+{
+    // The pool has not been started so the continuations stay in its queue.
+    ThreadPool threadPool( 1, std::nullopt );
+    Channel<int> channel( threadPool, 1 );
+
+    std::vector<int> received;
+    channel.asyncReceive( [&received]( std::optional<int> value ) { received.push_back( value.value() ); } );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+
+    // The value goes straight to the parked receiver. The completed send is not reported in
+    // the calling thread either.
+    bool sent = false;
+    channel.asyncSend( 10, [&sent]( bool ok ) { sent = ok; } );
+    EXPECT_FALSE( sent );
+    EXPECT_EQ( channel.getSize(), 0 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 2 );
+
+    // Fill the channel and park a sender.
+    channel.asyncSend( 11, {} );
+    bool parkedSent = false;
+    channel.asyncSend( 12, [&parkedSent]( bool ok ) { parkedSent = ok; } );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 2 );
+
+    // Receiving makes room for the parked value and wakes up the sender.
+    EXPECT_EQ( channel.tryReceive().value(), 11 );
+    EXPECT_EQ( channel.getSize(), 1 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 3 );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( received, std::vector<int>{ 10 } );
+    EXPECT_TRUE( sent );
+    EXPECT_TRUE( parkedSent );
+    EXPECT_EQ( channel.tryReceive().value(), 12 );
+}
+
+TEST( ChannelTest, InlineContinuationErrorsDoNotEscape )
+{
+    // The queue is full so the continuations are executed in the calling thread.
+    ThreadPool threadPool( 1, 1 );
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>( threadPool.generateId(), []() {} ) );
+    Channel<int> channel( threadPool, 1 );
+
+    bool called = false;
+    EXPECT_NO_THROW( channel.asyncSend( 1, [&called]( bool ) {
+        called = true;
+        throw std::runtime_error( "Send continuation failed." );
+    } ) );
+    EXPECT_TRUE( called );
+    called = false;
+    EXPECT_NO_THROW( channel.asyncReceive( [&called]( std::optional<int> ) {
+        called = true;
+        throw std::runtime_error( "Receive continuation failed." );
+    } ) );
+    EXPECT_TRUE( called );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+}
+
+TEST( ChannelTest, ReceiveLoopDoesNotRecurse )
+{
+    ThreadPool threadPool( 1, std::nullopt );
+    const int kNumValues = 10000;
+    Channel<int> channel( threadPool, kNumValues );
+    for( int i = 0; i < kNumValues; ++i )
+    {
+        EXPECT_TRUE( channel.trySend( std::move( i ) ) );
+    }
+
+    // Every value is available immediately. Re-arming from the callback must not nest the calls.
+    int depth = 0;
+    int maxDepth = 0;
+    int numReceived = 0;
+    std::function<void()> consume;
+    consume = [&]() {
+        channel.asyncReceive( [&]( std::optional<int> value ) {
+            if( !value.has_value() )
+            {
+                return;
+            }
+            ++depth;
+            maxDepth = std::max( maxDepth, depth );
+            ++numReceived;
+            consume();
+            --depth;
+        } );
+    };
+    consume();
+    channel.close();
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( numReceived, kNumValues );
+    EXPECT_EQ( maxDepth, 1 );
+}
+
+TEST( ChannelTest, CloseNotifiesParkedContinuations )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+
+    Channel<int> unbuffered( threadPool, 0 );
+    std::atomic<int> numClosedReceives{ 0 };
+    unbuffered.asyncReceive( [&numClosedReceives]( std::optional<int> value ) {
+        if( !value.has_value() )
+        {
+            ++numClosedReceives;
+        }
+    } );
+    unbuffered.close();
+
+    Channel<int> full( threadPool, 0 );
+    std::atomic<int> numFailedSends{ 0 };
+    full.asyncSend( 1, [&numFailedSends]( bool sent ) {
+        if( !sent )
+        {
+            ++numFailedSends;
+        }
+    } );
+    full.close();
+    // Receiving after closing gets nothing and does not park.
+    full.asyncReceive( [&numClosedReceives]( std::optional<int> value ) {
+        if( !value.has_value() )
+        {
+            ++numClosedReceives;
+        }
+    } );
+
+    threadPool.waitAllTasks();
+    EXPECT_EQ( numClosedReceives, 2 );
+    EXPECT_EQ( numFailedSends, 1 );
+}
+
+TEST( ChannelTest, ProducersAndConsumersDoNotBlockWorkers )
+{
+    // More producer and consumer chains than worker threads. A blocking queue would deadlock.
+    ThreadPool threadPool( 2, std::nullopt );
+    Channel<int> channel( threadPool, 4 );
+    const int kNumProducers = 4;
+    const int kNumValuesPerProducer = 200;
+    std::atomic<long> sum{ 0 };
+    std::atomic<int> numReceived{ 0 };
+
+    std::function<void( int, int )> produce;
+    produce = [&]( int producer, int next ) {
+        if( next == kNumValuesPerProducer )
+        {
+            return;
+        }
+        channel.asyncSend( producer * kNumValuesPerProducer + next, [&, producer, next]( bool sent ) {
+            if( sent )
+            {
+                threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+                    threadPool.generateId(), [&, producer, next]() { produce( producer, next + 1 ); } ) );
+            }
+        } );
+    };
+    std::function<void()> consume;
+    consume = [&]() {
+        channel.asyncReceive( [&]( std::optional<int> value ) {
+            if( value.has_value() )
+            {
+                sum += value.value();
+                ++numReceived;
+                consume();
+            }
+        } );
+    };
+
+    for( int i = 0; i < kNumProducers; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&produce, i]() { produce( i, 0 ); } ) );
+        threadPool.pushToQueue(
+            std::make_unique<threadpooluniverse::CallbackTask>( threadPool.generateId(), consume ) );
+    }
+    threadPool.startProcessing();
+
+    const int kTotal = kNumProducers * kNumValuesPerProducer;
+    for( int i = 0; i < 500 && numReceived < kTotal; ++i )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+    threadPool.waitAllTasks();
+    EXPECT_EQ( numReceived, kTotal );
+    EXPECT_EQ( sum, static_cast<long>( kTotal ) * ( kTotal - 1 ) / 2 );
+
+    channel.close();
+    threadPool.waitAllTasks();
+}
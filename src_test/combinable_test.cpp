@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <map>
+#include <set>
+#include "gtest/gtest.h"
+
+#include "callbacktask.h"
+#include "combinable.h"
+#include "threadpool.h"
+
+using threadpooluniverse::Combinable;
+using threadpooluniverse::ThreadPool;
+
+TEST( CombinableTest, CurrentWorkerIndex )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    EXPECT_FALSE( threadPool.getCurrentWorkerIndex().has_value() );
+
+    std::mutex indicesMutex;
+    std::set<size_t> indices;
+    for( int i = 0; i < 100; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&]() {
+                auto index = threadPool.getCurrentWorkerIndex();
+                ASSERT_TRUE( index.has_value() );
+                std::lock_guard<std::mutex> lock( indicesMutex );
+                indices.insert( index.value() );
+            } ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    ASSERT_FALSE( indices.empty() );
+    EXPECT_LT( *indices.rbegin(), 4 );
+}
+
+TEST( CombinableTest, SumAcrossWorkers )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    Combinable<long> partialSums( threadPool );
+    for( int i = 1; i <= 1000; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&partialSums, i]() { partialSums.local() += i; } ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    long total = partialSums.combine( []( long a, long b ) { return a + b; } );
+    EXPECT_EQ( total, 500500 );
+
+    int numCopies = 0;
+    partialSums.forEach( [&numCopies]( long& ) { ++numCopies; } );
+    EXPECT_GE( numCopies, 1 );
+    EXPECT_LE( numCopies, 4 );
+}
+
+TEST( CombinableTest, InitializerAndNonWorkerThreads )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    Combinable<std::map<int, int>> histograms( threadPool, []() {
+        return std::map<int, int>{ { 0, 0 } };
+    } );
+
+    // No copies yet so combine returns the initial value.
+    auto empty = histograms.combine( []( std::map<int, int> a, const std::map<int, int>& ) { return a; } );
+    EXPECT_EQ( empty.size(), 1 );
+
+    // The calling thread is not a worker thread but still gets its own copy.
+    histograms.local()[ 7 ] += 1;
+    histograms.local()[ 7 ] += 1;
+    EXPECT_EQ( histograms.local()[ 7 ], 2 );
+    EXPECT_EQ( histograms.local()[ 0 ], 0 );
+
+    histograms.clear();
+    int numCopies = 0;
+    histograms.forEach( [&numCopies]( std::map<int, int>& ) { ++numCopies; } );
+    EXPECT_EQ( numCopies, 0 );
+}
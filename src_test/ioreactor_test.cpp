@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#if defined( __linux__ )
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include "gtest/gtest.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "callbacktask.h"
+#include "ioreactor.h"
+#include "threadpool.h"
+
+using threadpooluniverse::IoReactor;
+using threadpooluniverse::ThreadPool;
+
+namespace
+{
+    template <typename Predicate>
+    bool waitUntil( Predicate predicate )
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        while( !predicate() )
+        {
+            if( std::chrono::steady_clock::now() - startTime > std::chrono::seconds( 10 ) )
+            {
+                return false;
+            }
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+        return true;
+    }
+
+    class Pipe
+    {
+    public:
+        Pipe()
+        {
+            int fds[ 2 ];
+            EXPECT_EQ( ::pipe( fds ), 0 );
+            readFd = fds[ 0 ];
+            writeFd = fds[ 1 ];
+        }
+
+        ~Pipe()
+        {
+            ::close( readFd );
+            ::close( writeFd );
+        }
+
+        int readFd{ -1 };
+        int writeFd{ -1 };
+    };
+}  // namespace
+
+TEST( IoReactorTest, ReadFromPipe )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+    Pipe pipe;
+
+    std::atomic_bool done{ false };
+    std::string received;
+    int readError = -1;
+    reactor.submitRead( pipe.readFd, 64, [&]( std::vector<char> data, int error ) {
+        received.assign( data.begin(), data.end() );
+        readError = error;
+        done.store( true );
+    } );
+    EXPECT_EQ( reactor.getNumberOfPendingOperations(), 1 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+
+    ASSERT_EQ( ::write( pipe.writeFd, "hello", 5 ), 5 );
+    ASSERT_TRUE( waitUntil( [&done]() { return done.load(); } ) );
+    EXPECT_EQ( received, "hello" );
+    EXPECT_EQ( readError, 0 );
+    EXPECT_EQ( reactor.getNumberOfPendingOperations(), 0 );
+}
+
+TEST( IoReactorTest, WatchReadable )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+    Pipe pipe;
+
+    std::atomic_bool continued{ false };
+    reactor.watch( pipe.readFd, IoReactor::IoEvent::Readable,
+                   std::make_unique<threadpooluniverse::CallbackTask>(
+                       threadPool.generateId(), [&continued]() { continued.store( true ); } ) );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    EXPECT_FALSE( continued.load() );
+
+    ASSERT_EQ( ::write( pipe.writeFd, "x", 1 ), 1 );
+    EXPECT_TRUE( waitUntil( [&continued]() { return continued.load(); } ) );
+}
+
+TEST( IoReactorTest, WriteMoreThanPipeCapacity )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+    Pipe pipe;
+
+    const size_t dataSize = 1024 * 1024;
+    std::atomic_bool done{ false };
+    size_t totalWritten = 0;
+    reactor.submitWrite( pipe.writeFd, std::vector<char>( dataSize, 'a' ),
+                         [&]( size_t bytesWritten, int error ) {
+                             EXPECT_EQ( error, 0 );
+                             totalWritten = bytesWritten;
+                             done.store( true );
+                         } );
+
+    size_t totalRead = 0;
+    char buffer[ 4096 ];
+    while( totalRead < dataSize )
+    {
+        ssize_t bytesRead = ::read( pipe.readFd, buffer, sizeof( buffer ) );
+        ASSERT_GT( bytesRead, 0 );
+        totalRead += static_cast<size_t>( bytesRead );
+    }
+    ASSERT_TRUE( waitUntil( [&done]() { return done.load(); } ) );
+    EXPECT_EQ( totalWritten, dataSize );
+}
+
+TEST( IoReactorTest, WriteToClosedSocketFailsWithEpipe )
+{
+    ThreadPool threadPool( 1, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+    int fds[ 2 ];
+    ASSERT_EQ( ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ), 0 );
+    ::close( fds[ 1 ] );
+
+    // Without handling, the write would raise SIGPIPE and terminate the test process.
+    std::atomic_int writeError{ 0 };
+    reactor.submitWrite( fds[ 0 ], std::vector<char>( 100, 'x' ),
+                         [&writeError]( size_t, int error ) { writeError.store( error ); } );
+    EXPECT_TRUE( waitUntil( [&writeError]() { return writeError.load() != 0; } ) );
+    EXPECT_EQ( writeError.load(), EPIPE );
+    ::close( fds[ 0 ] );
+}
+
+TEST( IoReactorTest, ReadRegularFile )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+
+    char path[] = "/tmp/ioreactortestXXXXXX";
+    int fd = ::mkstemp( path );
+    ASSERT_GE( fd, 0 );
+    ::unlink( path );
+    ASSERT_EQ( ::write( fd, "file content", 12 ), 12 );
+    ASSERT_EQ( ::lseek( fd, 0, SEEK_SET ), 0 );
+
+    std::atomic_bool done{ false };
+    std::string received;
+    reactor.submitRead( fd, 100, [&]( std::vector<char> data, int error ) {
+        EXPECT_EQ( error, 0 );
+        received.assign( data.begin(), data.end() );
+        done.store( true );
+    } );
+    ASSERT_TRUE( waitUntil( [&done]() { return done.load(); } ) );
+    EXPECT_EQ( received, "file content" );
+    ::close( fd );
+}
+
+TEST( IoReactorTest, CancelPendingRead )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+    IoReactor reactor( threadPool );
+    Pipe pipe;
+
+    std::atomic_int readError{ 0 };
+    reactor.submitRead( pipe.readFd, 64, [&readError]( std::vector<char>, int error ) {
+        readError.store( error );
+    } );
+    reactor.cancel( pipe.readFd );
+    EXPECT_EQ( reactor.getNumberOfPendingOperations(), 0 );
+    EXPECT_TRUE( waitUntil( [&readError]() { return readError.load() == ECANCELED; } ) );
+}
+
+TEST( IoReactorTest, CompletionsRunInReactorThreadWhenQueueIsFull )
+{
+    // The processing is not started so the queue stays full.
+    ThreadPool threadPool( 1, 1 );
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>( threadPool.generateId(), []() {} ) );
+    IoReactor reactor( threadPool );
+    Pipe pipe;
+
+    std::atomic_bool done{ false };
+    std::string received;
+    reactor.submitRead( pipe.readFd, 64, [&]( std::vector<char> data, int ) {
+        received.assign( data.begin(), data.end() );
+        done.store( true );
+    } );
+    ASSERT_EQ( ::write( pipe.writeFd, "data", 4 ), 4 );
+    ASSERT_TRUE( waitUntil( [&done]() { return done.load(); } ) );
+    EXPECT_EQ( received, "data" );
+
+    // The canceled operations are completed in the canceling thread.
+    int readError = 0;
+    reactor.submitRead( pipe.readFd, 64, [&readError]( std::vector<char>, int error ) { readError = error; } );
+    reactor.watch( pipe.readFd, IoReactor::IoEvent::Readable,
+                   std::make_unique<threadpooluniverse::CallbackTask>( threadPool.generateId(), []() {} ) );
+    reactor.cancel( pipe.readFd );
+    EXPECT_EQ( readError, ECANCELED );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1 );
+}
+
+#endif  // __linux__
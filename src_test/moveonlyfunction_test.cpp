@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "callbacktask.h"
+#include "moveonlyfunction.h"
+#include "threadpool.h"
+
+using threadpooluniverse::MoveOnlyFunction;
+
+namespace
+{
+    struct DestructionCounter
+    {
+        explicit DestructionCounter( int& counter ) :
+            mCounter( &counter )
+        {
+        }
+
+        DestructionCounter( DestructionCounter&& other ) noexcept :
+            mCounter( other.mCounter )
+        {
+            other.mCounter = nullptr;
+        }
+
+        ~DestructionCounter()
+        {
+            if( mCounter != nullptr )
+            {
+                ++( *mCounter );
+            }
+        }
+
+        int* mCounter;
+    };
+
+    int negate( int value )
+    {
+        return -value;
+    }
+}  // namespace
+
+TEST( MoveOnlyFunctionTest, Empty )
+{
+    MoveOnlyFunction<void()> empty;
+    EXPECT_FALSE( empty );
+    EXPECT_FALSE( empty.isStoredInline() );
+
+    MoveOnlyFunction<int( int )> fromNullPointer( static_cast<int ( * )( int )>( nullptr ) );
+    EXPECT_FALSE( fromNullPointer );
+
+    MoveOnlyFunction<void()> fromEmptyFunction( std::function<void()>{} );
+    EXPECT_FALSE( fromEmptyFunction );
+}
+
+TEST( MoveOnlyFunctionTest, SmallCallablesAreStoredInline )
+{
+    int multiplier = 3;
+    MoveOnlyFunction<int( int )> multiply( [multiplier]( int value ) { return value * multiplier; } );
+    ASSERT_TRUE( multiply );
+    EXPECT_TRUE( multiply.isStoredInline() );
+    EXPECT_EQ( multiply( 5 ), 15 );
+
+    // A lambda that captures a unique_ptr cannot be stored to std::function.
+    auto text = std::make_unique<std::string>( "abc" );
+    MoveOnlyFunction<size_t()> length( [text = std::move( text )]() { return text->size(); } );
+    EXPECT_TRUE( length.isStoredInline() );
+
+    MoveOnlyFunction<size_t()> moved( std::move( length ) );
+    EXPECT_FALSE( length );
+    EXPECT_EQ( moved(), 3 );
+
+    MoveOnlyFunction<int( int )> freeFunction( &negate );
+    EXPECT_EQ( freeFunction( 2 ), -2 );
+}
+
+TEST( MoveOnlyFunctionTest, LargeCallablesAreStoredInHeap )
+{
+    std::array<char, 128> large{};
+    large[ 100 ] = 'x';
+    MoveOnlyFunction<char()> function( [large]() { return large[ 100 ]; } );
+    EXPECT_FALSE( function.isStoredInline() );
+    EXPECT_EQ( function(), 'x' );
+
+    MoveOnlyFunction<char()> other;
+    other = std::move( function );
+    EXPECT_FALSE( function );
+    EXPECT_EQ( other(), 'x' );
+
+    // The inline buffer size can be configured.
+    MoveOnlyFunction<char(), 256> bigBuffer( [large]() { return large[ 100 ]; } );
+    EXPECT_TRUE( bigBuffer.isStoredInline() );
+}
+
+TEST( MoveOnlyFunctionTest, DestroysCallableOnce )
+{
+    int numDestroyed = 0;
+    {
+        MoveOnlyFunction<void()> first( [counter = DestructionCounter( numDestroyed )]() {} );
+        MoveOnlyFunction<void()> second( std::move( first ) );
+        MoveOnlyFunction<void()> third;
+        third = std::move( second );
+        EXPECT_EQ( numDestroyed, 0 );
+    }
+    EXPECT_EQ( numDestroyed, 1 );
+
+    MoveOnlyFunction<void()> reset( [counter = DestructionCounter( numDestroyed )]() {} );
+    reset = nullptr;
+    EXPECT_FALSE( reset );
+    EXPECT_EQ( numDestroyed, 2 );
+}
+
+TEST( MoveOnlyFunctionTest, CallbackTaskTakesMoveOnlyCaptures )
+{
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    auto buffer = std::make_unique<std::array<int, 1000>>();
+    int result = 0;
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+        threadPool.generateId(), [buffer = std::move( buffer ), &result]() {
+            ( *buffer )[ 999 ] = 7;
+            result = ( *buffer )[ 999 ];
+        } ) );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( result, 7 );
+}
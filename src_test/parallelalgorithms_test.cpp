@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "parallelalgorithms.h"
+#include "threadpool.h"
+
+using threadpooluniverse::ThreadPool;
+
+namespace
+{
+    std::vector<int> makeRandomValues( size_t count, int maxValue )
+    {
+        std::mt19937 generator( static_cast<unsigned int>( count ) );
+        std::uniform_int_distribution<int> distribution( 0, maxValue );
+        std::vector<int> values( count );
+        for( auto& value : values )
+        {
+            value = distribution( generator );
+        }
+        return values;
+    }
+}  // namespace
+
+TEST( ParallelAlgorithmsTest, ParallelForCallsEveryIndexOnce )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    threadPool.startProcessing();
+
+    std::vector<int> calls( 1000, 0 );
+    threadpooluniverse::parallelFor( threadPool, calls.size(), [&calls]( size_t index ) { ++calls[ index ]; } );
+    EXPECT_EQ( std::count( calls.begin(), calls.end(), 1 ), 1000 );
+
+    // The exception is rethrown in the calling thread.
+    EXPECT_THROW( threadpooluniverse::parallelFor( threadPool, 100,
+                                                   []( size_t index ) {
+                                                       if( index == 50 )
+                                                       {
+                                                           throw std::runtime_error( "failed" );
+                                                       }
+                                                   } ),
+                  std::runtime_error );
+    threadPool.waitAllTasks();
+}
+
+TEST( ParallelAlgorithmsTest, CallingThreadCompletesWithoutWorkers )
+{
+    // The processing has not been started so the calling thread does all the work.
+    ThreadPool threadPool( 2, std::nullopt );
+    auto values = makeRandomValues( 100000, 1000 );
+    auto expected = values;
+    std::sort( expected.begin(), expected.end() );
+    threadpooluniverse::parallelSort( threadPool, values.begin(), values.end() );
+    EXPECT_EQ( values, expected );
+}
+
+TEST( ParallelAlgorithmsTest, Sort )
+{
+    ThreadPool threadPool( 3, std::nullopt );
+    threadPool.startProcessing();
+    for( size_t count : { 0, 1, 100, 20000, 100001, 500000 } )
+    {
+        auto values = makeRandomValues( count, 1000 );
+        auto expected = values;
+        std::sort( expected.begin(), expected.end() );
+        threadpooluniverse::parallelSort( threadPool, values.begin(), values.end() );
+        EXPECT_EQ( values, expected ) << "count " << count;
+    }
+
+    // Descending order with an element type whose moved-from values differ from the originals.
+    std::vector<std::string> strings;
+    for( int value : makeRandomValues( 50000, 100000 ) )
+    {
+        strings.push_back( std::to_string( value ) );
+    }
+    auto expected = strings;
+    std::sort( expected.begin(), expected.end(), std::greater<>() );
+    threadpooluniverse::parallelSort( threadPool, strings.begin(), strings.end(), std::greater<>() );
+    EXPECT_EQ( strings, expected );
+
+    // Move-only element type.
+    auto values = makeRandomValues( 50000, 100000 );
+    std::vector<std::unique_ptr<int>> pointers;
+    for( int value : values )
+    {
+        pointers.push_back( std::make_unique<int>( value ) );
+    }
+    threadpooluniverse::parallelSort(
+        threadPool, pointers.begin(), pointers.end(),
+        []( const std::unique_ptr<int>& a, const std::unique_ptr<int>& b ) { return *a < *b; } );
+    ASSERT_EQ( std::count( pointers.begin(), pointers.end(), nullptr ), 0 );
+    std::sort( values.begin(), values.end() );
+    std::vector<int> sortedValues;
+    for( const auto& pointer : pointers )
+    {
+        sortedValues.push_back( *pointer );
+    }
+    EXPECT_EQ( sortedValues, values );
+}
+
+TEST( ParallelAlgorithmsTest, Scan )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    threadPool.startProcessing();
+    for( size_t count : { 0, 1, 100, 30000, 250001 } )
+    {
+        auto values = makeRandomValues( count, 100 );
+        std::vector<long long> input( values.begin(), values.end() );
+
+        std::vector<long long> expected( count );
+        std::vector<long long> output( count );
+        std::inclusive_scan( input.begin(), input.end(), expected.begin() );
+        auto outputEnd = threadpooluniverse::parallelInclusiveScan( threadPool, input.begin(), input.end(),
+                                                                    output.begin() );
+        EXPECT_EQ( outputEnd, output.end() );
+        EXPECT_EQ( output, expected ) << "count " << count;
+
+        std::exclusive_scan( input.begin(), input.end(), expected.begin(), 10LL );
+        threadpooluniverse::parallelExclusiveScan( threadPool, input.begin(), input.end(), output.begin(), 10LL );
+        EXPECT_EQ( output, expected ) << "count " << count;
+
+        // In place.
+        std::inclusive_scan( input.begin(), input.end(), expected.begin() );
+        threadpooluniverse::parallelInclusiveScan( threadPool, input.begin(), input.end(), input.begin() );
+        EXPECT_EQ( input, expected ) << "count " << count;
+    }
+
+    // A non-commutative operation keeps the order of the operands.
+    std::vector<std::string> letters( 40000, "a" );
+    letters[ 0 ] = "b";
+    std::vector<std::string> concatenated( letters.size() );
+    threadpooluniverse::parallelInclusiveScan( threadPool, letters.begin(), letters.end(), concatenated.begin(),
+                                               []( const std::string& a, const std::string& b ) {
+                                                   return ( a + b ).substr( 0, 3 );
+                                               } );
+    EXPECT_EQ( concatenated[ 1 ], "ba" );
+    EXPECT_EQ( concatenated.back(), "baa" );
+}
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "pipeline.h"
+#include "threadpool.h"
+#include "threadpoolexceptions.h"
+
+using threadpooluniverse::Pipeline;
+using threadpooluniverse::ThreadPool;
+
+TEST( PipelineTest, SerialInOrderStageKeepsSourceOrder )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    threadPool.startProcessing();
+
+    Pipeline<int> pipeline( threadPool, 8 );
+    pipeline.addStage( Pipeline<int>::StageMode::Parallel, []( int& item ) {
+        std::this_thread::sleep_for( std::chrono::microseconds( ( item * 7 ) % 13 * 100 ) );
+        item = item * 2;
+    } );
+    std::vector<int> output;
+    pipeline.addStage( Pipeline<int>::StageMode::SerialInOrder,
+                       [&output]( int& item ) { output.push_back( item ); } );
+
+    int next = 0;
+    pipeline.run( [&next]( int& item ) {
+        if( next == 500 )
+        {
+            return false;
+        }
+        item = next++;
+        return true;
+    } );
+
+    ASSERT_EQ( output.size(), 500 );
+    for( int i = 0; i < 500; ++i )
+    {
+        EXPECT_EQ( output[ i ], i * 2 );
+    }
+}
+
+TEST( PipelineTest, TokensInFlightAreBounded )
+{
+    ThreadPool threadPool( 4, std::nullopt );
+    threadPool.startProcessing();
+
+    const size_t maxTokens = 3;
+    std::atomic_int inFlight{ 0 };
+    std::atomic_int maxInFlight{ 0 };
+    std::atomic_int anyOrderConcurrency{ 0 };
+    std::atomic_bool anyOrderOverlapped{ false };
+    std::atomic_int processed{ 0 };
+
+    Pipeline<int> pipeline( threadPool, maxTokens );
+    pipeline.addStage( Pipeline<int>::StageMode::Parallel, []( int& ) {
+        std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+    } );
+    pipeline.addStage( Pipeline<int>::StageMode::SerialAnyOrder, [&]( int& ) {
+        if( anyOrderConcurrency.fetch_add( 1 ) != 0 )
+        {
+            anyOrderOverlapped.store( true );
+        }
+        std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+        anyOrderConcurrency.fetch_sub( 1 );
+        processed.fetch_add( 1 );
+        inFlight.fetch_sub( 1 );
+    } );
+
+    int produced = 0;
+    pipeline.run( [&]( int& item ) {
+        if( produced == 200 )
+        {
+            return false;
+        }
+        item = produced++;
+        int current = inFlight.fetch_add( 1 ) + 1;
+        int previousMax = maxInFlight.load();
+        while( current > previousMax && !maxInFlight.compare_exchange_weak( previousMax, current ) )
+        {
+        }
+        return true;
+    } );
+
+    EXPECT_EQ( processed.load(), 200 );
+    EXPECT_LE( maxInFlight.load(), static_cast<int>( maxTokens ) );
+    EXPECT_FALSE( anyOrderOverlapped.load() );
+}
+
+TEST( PipelineTest, StageExceptionIsRethrown )
+{
+    ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+
+    Pipeline<int> pipeline( threadPool, 4 );
+    pipeline.addStage( Pipeline<int>::StageMode::Parallel, []( int& item ) {
+        if( item == 10 )
+        {
+            throw std::runtime_error( "Error for the test" );
+        }
+    } );
+    pipeline.addStage( Pipeline<int>::StageMode::SerialInOrder, []( int& ) {} );
+
+    int next = 0;
+    EXPECT_THROW( pipeline.run( [&next]( int& item ) {
+        item = next++;
+        return true;
+    } ),
+                  std::runtime_error );
+
+    // The pipeline can be run again after a failure.
+    int count = 0;
+    next = 0;
+    pipeline.run( [&]( int& item ) {
+        item = 100 + next++;
+        return ++count <= 20;
+    } );
+    EXPECT_EQ( count, 21 );
+}
+
+TEST( PipelineTest, ClearingQueueFailsRunInsteadOfHanging )
+{
+    ThreadPool threadPool( 1, std::nullopt );
+    threadPool.startProcessing();
+
+    std::atomic_bool release{ false };
+    std::atomic_int numStageCalls{ 0 };
+    Pipeline<int> pipeline( threadPool, 4 );
+    pipeline.addStage( Pipeline<int>::StageMode::Parallel, [&]( int& ) {
+        ++numStageCalls;
+        while( !release.load() )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    } );
+    pipeline.addStage( Pipeline<int>::StageMode::SerialInOrder, []( int& ) {} );
+
+    std::atomic_bool failed{ false };
+    std::thread runner( [&]() {
+        int next = 0;
+        try
+        {
+            pipeline.run( [&next]( int& item ) {
+                item = next;
+                return next++ < 4;
+            } );
+        }
+        catch( const threadpooluniverse::TaskDroppedException& )
+        {
+            failed.store( true );
+        }
+    } );
+
+    // The first item blocks the only worker and the other three wait in the queue.
+    while( numStageCalls.load() == 0 || threadPool.getNumberOfTasks() < 4 )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    threadPool.clearQueue();
+    release.store( true );
+    runner.join();
+    EXPECT_TRUE( failed.load() );
+    EXPECT_EQ( numStageCalls.load(), 1 );
+    threadPool.waitAllTasks();
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <cstdint>
+#include <new>
+#include "gtest/gtest.h"
+
+#include "scratcharena.h"
+
+using threadpooluniverse::ScratchArena;
+
+TEST( ScratchArenaTest, AllocatesAlignedMemory )
+{
+    ScratchArena arena( 1024 );
+    EXPECT_EQ( arena.getCapacity(), 0 );
+
+    void* first = arena.allocate( 3, 1 );
+    void* second = arena.allocate( 16, 64 );
+    EXPECT_NE( first, nullptr );
+    EXPECT_EQ( reinterpret_cast<uintptr_t>( second ) % 64, 0 );
+    EXPECT_GE( arena.getBytesAllocated(), 19 );
+    EXPECT_EQ( arena.getCapacity(), 1024 );
+
+    double* values = arena.allocateArray<double>( 10 );
+    for( int i = 0; i < 10; ++i )
+    {
+        EXPECT_EQ( values[ i ], 0.0 );
+    }
+}
+
+TEST( ScratchArenaTest, ResetReusesMemory )
+{
+    ScratchArena arena( 1024 );
+    void* first = arena.allocate( 100 );
+    arena.reset();
+    EXPECT_EQ( arena.getBytesAllocated(), 0 );
+    EXPECT_EQ( arena.allocate( 100 ), first );
+}
+
+TEST( ScratchArenaTest, ResetMergesBlocks )
+{
+    ScratchArena arena( 1024 );
+    arena.allocate( 800 );
+    arena.allocate( 800 );
+    arena.allocate( 4000 );
+    size_t capacity = arena.getCapacity();
+    EXPECT_GE( capacity, 5600 );
+
+    // After reset the same allocations fit in the single merged block.
+    arena.reset();
+    EXPECT_EQ( arena.getCapacity(), capacity );
+    arena.allocate( 800 );
+    arena.allocate( 800 );
+    arena.allocate( 4000 );
+    EXPECT_EQ( arena.getCapacity(), capacity );
+}
+
+TEST( ScratchArenaTest, ResetFreesMemoryAboveRetentionLimit )
+{
+    ScratchArena arena( 1024, 4096 );
+    arena.allocate( 2000 );
+    size_t capacity = arena.getCapacity();
+    arena.reset();
+    EXPECT_EQ( arena.getCapacity(), capacity );
+
+    arena.allocate( 8000 );
+    arena.reset();
+    EXPECT_EQ( arena.getCapacity(), 0 );
+    EXPECT_NE( arena.allocate( 100 ), nullptr );
+    EXPECT_EQ( arena.getCapacity(), 1024 );
+}
+
+TEST( ScratchArenaTest, OverflowingArrayThrows )
+{
+    ScratchArena arena( 1024 );
+    EXPECT_THROW( arena.allocateArray<uint64_t>( SIZE_MAX / 4 ), std::bad_array_new_length );
+    EXPECT_EQ( arena.getCapacity(), 0 );
+}
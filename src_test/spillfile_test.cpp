@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <csignal>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#include "gtest/gtest.h"
+
+#if defined( __linux__ )
+#include <sys/resource.h>
+#endif
+
+#include "spillfile.h"
+
+using threadpooluniverse::SpillFile;
+using threadpooluniverse::TaskBase;
+
+TEST( SpillFileTest, RecordsAreReadInOrder )
+{
+    SpillFile spillFile( std::filesystem::temp_directory_path().string() );
+    auto now = TaskBase::Clock::now();
+
+    // Enough data to grow the file beyond its initial size.
+    std::vector<char> data( 3000 );
+    for( uint64_t i = 0; i < 2000; ++i )
+    {
+        data.resize( 1000 + i % 7 );
+        data[ 0 ] = static_cast<char>( i );
+        std::optional<TaskBase::Clock::time_point> deadline;
+        if( i % 2 == 0 )
+        {
+            deadline = now + std::chrono::seconds( i );
+        }
+        spillFile.append( i, now, deadline, data );
+    }
+    EXPECT_EQ( spillFile.getNumberOfRecords(), 2000 );
+    EXPECT_TRUE( spillFile.remove( 5 ) );
+    EXPECT_FALSE( spillFile.remove( 5 ) );
+
+    SpillFile::Record record;
+    for( uint64_t i = 0; i < 2000; ++i )
+    {
+        if( i == 5 )
+        {
+            continue;
+        }
+        ASSERT_TRUE( spillFile.read( record ) );
+        EXPECT_EQ( record.taskId, i );
+        EXPECT_EQ( record.queuedTime, now );
+        EXPECT_EQ( record.deadline.has_value(), i % 2 == 0 );
+        EXPECT_EQ( record.data.size(), 1000 + i % 7 );
+        EXPECT_EQ( record.data[ 0 ], static_cast<char>( i ) );
+    }
+    EXPECT_FALSE( spillFile.read( record ) );
+    EXPECT_EQ( spillFile.getNumberOfRecords(), 0 );
+
+    // The file is reused after it has been emptied.
+    spillFile.append( 42, now, std::nullopt, {} );
+    ASSERT_TRUE( spillFile.read( record ) );
+    EXPECT_EQ( record.taskId, 42 );
+    EXPECT_TRUE( record.data.empty() );
+}
+
+#if defined( __linux__ )
+TEST( SpillFileTest, FailedGrowKeepsRecords )
+{
+    // Limit the file size so that the file cannot grow beyond its initial size. Exceeding the
+    // limit fails with EFBIG when SIGXFSZ is ignored.
+    rlimit oldLimit{};
+    ASSERT_EQ( ::getrlimit( RLIMIT_FSIZE, &oldLimit ), 0 );
+    auto oldHandler = std::signal( SIGXFSZ, SIG_IGN );
+    SpillFile spillFile( std::filesystem::temp_directory_path().string() );
+    rlimit limit = oldLimit;
+    limit.rlim_cur = 1536 * 1024;
+    ASSERT_EQ( ::setrlimit( RLIMIT_FSIZE, &limit ), 0 );
+
+    auto now = TaskBase::Clock::now();
+    std::vector<char> data( 1000 );
+    uint64_t numAppended = 0;
+    bool failed = false;
+    for( ; numAppended < 2000; ++numAppended )
+    {
+        data[ 0 ] = static_cast<char>( numAppended );
+        try
+        {
+            spillFile.append( numAppended, now, std::nullopt, data );
+        }
+        catch( const std::system_error& )
+        {
+            failed = true;
+            break;
+        }
+    }
+    ::setrlimit( RLIMIT_FSIZE, &oldLimit );
+    std::signal( SIGXFSZ, oldHandler );
+    ASSERT_TRUE( failed );
+
+    // The records appended before the failure can still be read.
+    EXPECT_EQ( spillFile.getNumberOfRecords(), numAppended );
+    SpillFile::Record record;
+    for( uint64_t i = 0; i < numAppended; ++i )
+    {
+        ASSERT_TRUE( spillFile.read( record ) );
+        EXPECT_EQ( record.taskId, i );
+        EXPECT_EQ( record.data[ 0 ], static_cast<char>( i ) );
+    }
+    EXPECT_FALSE( spillFile.read( record ) );
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2025 Tomi Lamminsaari
+ *
+ * This software is licensed under the MIT License.
+ * See the accompanying LICENSE file for more details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "callbacktask.h"
+#include "systemresources.h"
+#include "threadpool.h"
+
+using threadpooluniverse::SystemResources;
+
+namespace
+{
+    /**
+     * Temporary directory with fake cgroup files. Removed when destroyed.
+     */
+    class FakeCgroupFiles
+    {
+    public:
+        explicit FakeCgroupFiles( const std::string& name ) :
+            mRoot( std::filesystem::temp_directory_path() / ( "threadpooluniverse_" + name ) )
+        {
+            std::filesystem::remove_all( mRoot );
+            std::filesystem::create_directories( mRoot / "fs" );
+        }
+
+        ~FakeCgroupFiles()
+        {
+            std::filesystem::remove_all( mRoot );
+        }
+
+        void write( const std::string& relativePath, const std::string& content )
+        {
+            std::filesystem::path path = mRoot / relativePath;
+            std::filesystem::create_directories( path.parent_path() );
+            std::ofstream file( path );
+            file << content;
+        }
+
+        SystemResources createSystemResources() const
+        {
+            return SystemResources( ( mRoot / "fs" ).string(), ( mRoot / "cgroup" ).string() );
+        }
+
+    private:
+        std::filesystem::path mRoot;
+    };
+}  // namespace
+
+TEST( SystemResourcesTest, CgroupV2Quota )
+{
+    FakeCgroupFiles files( "cgroupv2" );
+    files.write( "cgroup", "0::/app/worker\n" );
+    files.write( "fs/app/cpu.max", "250000 100000\n" );
+    files.write( "fs/app/worker/cpu.max", "max 100000\n" );
+
+    // The parent limits the child that has no quota of its own.
+    auto resources = files.createSystemResources();
+    ASSERT_TRUE( resources.getCpuQuota().has_value() );
+    EXPECT_DOUBLE_EQ( resources.getCpuQuota().value(), 2.5 );
+    EXPECT_EQ( resources.getNumberOfAvailableCpus(), std::min<size_t>( 3, resources.getNumberOfAffinityCpus() ) );
+
+    // The smallest quota of the hierarchy wins.
+    files.write( "fs/app/worker/cpu.max", "50000 100000\n" );
+    EXPECT_DOUBLE_EQ( resources.getCpuQuota().value(), 0.5 );
+    EXPECT_EQ( resources.getNumberOfAvailableCpus(), 1 );
+}
+
+TEST( SystemResourcesTest, CgroupV1QuotaInContainer )
+{
+    FakeCgroupFiles files( "cgroupv1" );
+    files.write( "cgroup", "5:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n0::/\n" );
+    // The host path of the cgroup does not exist in the container. The mount root has the
+    // quota of the container.
+    files.write( "fs/cpu,cpuacct/cpu.cfs_quota_us", "400000\n" );
+    files.write( "fs/cpu,cpuacct/cpu.cfs_period_us", "100000\n" );
+
+    auto resources = files.createSystemResources();
+    ASSERT_TRUE( resources.getCpuQuota().has_value() );
+    EXPECT_DOUBLE_EQ( resources.getCpuQuota().value(), 4.0 );
+
+    files.write( "fs/cpu,cpuacct/cpu.cfs_quota_us", "-1\n" );
+    EXPECT_FALSE( resources.getCpuQuota().has_value() );
+}
+
+TEST( SystemResourcesTest, MalformedCgroupPath )
+{
+    FakeCgroupFiles files( "malformed" );
+    files.write( "cgroup", "0::app\n" );
+    files.write( "fs/cpu.max", "200000 100000\n" );
+
+    // The path without slashes does not throw and the mount root is still checked.
+    auto resources = files.createSystemResources();
+    ASSERT_TRUE( resources.getCpuQuota().has_value() );
+    EXPECT_DOUBLE_EQ( resources.getCpuQuota().value(), 2.0 );
+}
+
+TEST( SystemResourcesTest, NoCgroupFiles )
+{
+    FakeCgroupFiles files( "nocgroup" );
+    auto resources = files.createSystemResources();
+    EXPECT_FALSE( resources.getCpuQuota().has_value() );
+    EXPECT_GE( resources.getNumberOfAffinityCpus(), 1 );
+    EXPECT_EQ( resources.getNumberOfAvailableCpus(), resources.getNumberOfAffinityCpus() );
+}
+
+TEST( SystemResourcesTest, SharedDefaultThreadPool )
+{
+    EXPECT_GE( threadpooluniverse::ThreadPool::getDefaultNumberOfThreads(), 1 );
+
+    auto& threadPool = threadpooluniverse::ThreadPool::getSharedDefault();
+    EXPECT_EQ( &threadPool, &threadpooluniverse::ThreadPool::getSharedDefault() );
+    EXPECT_EQ( threadPool.getNumberOfThreads(), threadpooluniverse::ThreadPool::getDefaultNumberOfThreads() );
+
+    std::atomic<bool> executed{ false };
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+        threadPool.generateId(), [&executed]() { executed = true; } ) );
+    threadPool.waitAllTasks();
+    EXPECT_TRUE( executed );
+}
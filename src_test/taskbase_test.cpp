@@ -23,3 +23,19 @@ TEST( TaskBaseTest, Cancel )
     task.cancel();
     EXPECT_TRUE( task.isCanceled() );
 }
+
+TEST( TaskBaseTest, Deadline )
+{
+    threadpooluniverse::DummyTask task( 42 );
+    auto now = threadpooluniverse::TaskBase::Clock::now();
+    EXPECT_FALSE( task.getDeadline().has_value() );
+    EXPECT_FALSE( task.isExpired( now ) );
+
+    task.setDeadline( now );
+    EXPECT_EQ( task.getDeadline(), now );
+    EXPECT_FALSE( task.isExpired( now ) );
+    EXPECT_TRUE( task.isExpired( now + std::chrono::milliseconds( 1 ) ) );
+
+    task.setDeadline( std::nullopt );
+    EXPECT_FALSE( task.isExpired( now + std::chrono::milliseconds( 1 ) ) );
+}
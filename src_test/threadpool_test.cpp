@@ -5,15 +5,53 @@
  * See the accompanying LICENSE file for more details.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "callbacktask.h"
+#include "scratcharena.h"
+#include "serializabletask.h"
 #include "threadpool.h"
 #include "threadpoolexceptions.h"
 #include "util/dummytask.h"
 using threadpooluniverse::DummyTask;
 
+namespace
+{
+    class ExpiryCountingTask : public threadpooluniverse::TaskBase
+    {
+    public:
+        ExpiryCountingTask( uint64_t taskId, std::atomic_int& executed, std::atomic_int& expired ) :
+            TaskBase( taskId ),
+            mExecuted( executed ),
+            mExpired( expired )
+        {
+        }
+
+        virtual void execute() override
+        {
+            mExecuted.fetch_add( 1 );
+        }
+
+        virtual void handleExpired() override
+        {
+            mExpired.fetch_add( 1 );
+        }
+
+    private:
+        std::atomic_int& mExecuted;
+        std::atomic_int& mExpired;
+    };
+}  // namespace
+
 TEST( ThreadPoolTest, CreateDestroy )
 {
     threadpooluniverse::ThreadPool threadPool( 4, std::nullopt );
@@ -34,6 +72,18 @@ TEST( ThreadPoolTest, PushToQueueThrowsWhenFull )
         threadpooluniverse::TaskQueueFullException );
 }
 
+TEST( ThreadPoolTest, TryPushToQueueReturnsRejectedTask )
+{
+    threadpooluniverse::ThreadPool threadPool( 4, 1 );
+    EXPECT_EQ( threadPool.tryPushToQueue( std::make_unique<DummyTask>( threadPool.generateId() ) ), nullptr );
+
+    uint64_t taskId = threadPool.generateId();
+    auto rejectedTask = threadPool.tryPushToQueue( std::make_unique<DummyTask>( taskId ) );
+    ASSERT_NE( rejectedTask, nullptr );
+    EXPECT_EQ( rejectedTask->getTaskId(), taskId );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1 );
+}
+
 TEST( ThreadPoolTest, ProcessTasks )
 {
     threadpooluniverse::ThreadPool threadPool( 4, std::nullopt );
@@ -122,3 +172,869 @@ TEST( ThreadPoolTest, TaskCanHandleErrors )
     EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
     EXPECT_EQ( errorsHandled.load(), 50 );
 }
+
+TEST( ThreadPoolTest, EarliestDeadlineFirst )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    threadPool.setSchedulingPolicy(
+        threadpooluniverse::ThreadPool::SchedulingPolicy::EarliestDeadlineFirst );
+
+    std::vector<int> executionOrder;
+    auto now = threadpooluniverse::TaskBase::Clock::now();
+    const int deadlineOffsets[] = { 50, 10, -1, 30, 20, -1, 40 };
+    for( int offset : deadlineOffsets )
+    {
+        auto task = std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(),
+            [&executionOrder, offset]() { executionOrder.push_back( offset ); } );
+        if( offset >= 0 )
+        {
+            task->setDeadline( now + std::chrono::seconds( offset ) );
+        }
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    const std::vector<int> expectedOrder = { 10, 20, 30, 40, 50, -1, -1 };
+    EXPECT_EQ( executionOrder, expectedOrder );
+}
+
+TEST( ThreadPoolTest, SwitchingToEarliestDeadlineFirstReordersQueue )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    std::vector<int> executionOrder;
+    auto now = threadpooluniverse::TaskBase::Clock::now();
+    for( int offset : { 3, 1, 2 } )
+    {
+        auto task = std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(),
+            [&executionOrder, offset]() { executionOrder.push_back( offset ); } );
+        task->setDeadline( now + std::chrono::seconds( offset ) );
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.setSchedulingPolicy(
+        threadpooluniverse::ThreadPool::SchedulingPolicy::EarliestDeadlineFirst );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    const std::vector<int> expectedOrder = { 1, 2, 3 };
+    EXPECT_EQ( executionOrder, expectedOrder );
+}
+
+TEST( ThreadPoolTest, SwitchingBackToFifoRestoresPushOrder )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    threadPool.setSchedulingPolicy(
+        threadpooluniverse::ThreadPool::SchedulingPolicy::EarliestDeadlineFirst );
+    std::vector<int> executionOrder;
+    auto now = threadpooluniverse::TaskBase::Clock::now();
+    for( int offset : { 3, 1, 2 } )
+    {
+        auto task = std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(),
+            [&executionOrder, offset]() { executionOrder.push_back( offset ); } );
+        task->setDeadline( now + std::chrono::seconds( offset ) );
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.setSchedulingPolicy( threadpooluniverse::ThreadPool::SchedulingPolicy::Fifo );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    const std::vector<int> expectedOrder = { 3, 1, 2 };
+    EXPECT_EQ( executionOrder, expectedOrder );
+}
+
+TEST( ThreadPoolTest, DropExpiredTasks )
+{
+    threadpooluniverse::ThreadPool threadPool( 4, std::nullopt );
+    threadPool.setExpiryPolicy( threadpooluniverse::ThreadPool::ExpiryPolicy::DropExpired );
+
+    std::atomic_int executed{ 0 };
+    std::atomic_int expired{ 0 };
+    auto now = threadpooluniverse::TaskBase::Clock::now();
+    for( int i = 0; i < 40; ++i )
+    {
+        auto task = std::make_unique<ExpiryCountingTask>( threadPool.generateId(), executed, expired );
+        if( i % 2 == 0 )
+        {
+            task->setDeadline( now - std::chrono::seconds( 1 ) );
+        }
+        else
+        {
+            task->setDeadline( now + std::chrono::hours( 1 ) );
+        }
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    EXPECT_EQ( executed.load(), 20 );
+    EXPECT_EQ( expired.load(), 20 );
+    EXPECT_EQ( threadPool.getNumberOfExpiredTasks(), 20 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+}
+
+TEST( ThreadPoolTest, BatchedTasksThatExpireAreDropped )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    std::atomic_bool firstTaskStarted{ false };
+    std::atomic_bool release{ false };
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+        threadPool.generateId(), [&firstTaskStarted, &release]() {
+            firstTaskStarted.store( true );
+            while( !release.load() )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            }
+        } ) );
+    std::atomic_int executed{ 0 };
+    std::atomic_int expired{ 0 };
+    auto deadline = threadpooluniverse::TaskBase::Clock::now() + std::chrono::milliseconds( 50 );
+    for( int i = 0; i < 20; ++i )
+    {
+        auto task = std::make_unique<ExpiryCountingTask>( threadPool.generateId(), executed, expired );
+        task->setDeadline( deadline );
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.startProcessing();
+    while( !firstTaskStarted.load() )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    // The worker has taken some of the tasks in a batch before they expired.
+    threadPool.setExpiryPolicy( threadpooluniverse::ThreadPool::ExpiryPolicy::DropExpired );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+    release.store( true );
+    threadPool.waitAllTasks();
+
+    EXPECT_EQ( executed.load(), 0 );
+    EXPECT_EQ( expired.load(), 20 );
+    EXPECT_EQ( threadPool.getNumberOfExpiredTasks(), 20 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+}
+
+TEST( ThreadPoolTest, ExpiredTasksAreExecutedByDefault )
+{
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    std::atomic_int executed{ 0 };
+    std::atomic_int expired{ 0 };
+    for( int i = 0; i < 10; ++i )
+    {
+        auto task = std::make_unique<ExpiryCountingTask>( threadPool.generateId(), executed, expired );
+        task->setDeadline( threadpooluniverse::TaskBase::Clock::now() - std::chrono::seconds( 1 ) );
+        threadPool.pushToQueue( std::move( task ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    EXPECT_EQ( executed.load(), 10 );
+    EXPECT_EQ( expired.load(), 0 );
+    EXPECT_EQ( threadPool.getNumberOfExpiredTasks(), 0 );
+}
+
+TEST( ThreadPoolTest, LazyWorkerStartup )
+{
+    threadpooluniverse::ThreadPool threadPool( 4, std::nullopt,
+                                               threadpooluniverse::ThreadPool::WorkerStartup::Lazy );
+    EXPECT_EQ( threadPool.getNumberOfThreads(), 4 );
+    EXPECT_EQ( threadPool.getNumberOfRunningThreads(), 0 );
+    EXPECT_EQ( threadPool.getNumberOfIdleThreads(), 0 );
+    EXPECT_FALSE( threadPool.allThreadsRunning() );
+    threadPool.startProcessing();
+
+    // Tasks that block until released force the pool to create all the workers.
+    std::atomic_bool release{ false };
+    std::atomic_int tasksExecuted{ 0 };
+    for( int i = 0; i < 8; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&release, &tasksExecuted]() {
+                while( !release.load() )
+                {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+                tasksExecuted.fetch_add( 1 );
+            } ) );
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    while( !threadPool.allThreadsRunning() &&
+           std::chrono::steady_clock::now() - startTime < std::chrono::seconds( 10 ) )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    EXPECT_TRUE( threadPool.allThreadsRunning() );
+    EXPECT_EQ( threadPool.getNumberOfRunningThreads(), 4 );
+
+    release.store( true );
+    threadPool.waitAllTasks();
+    EXPECT_EQ( tasksExecuted.load(), 8 );
+}
+
+TEST( ThreadPoolTest, NonBlockingWorkerStartup )
+{
+    threadpooluniverse::ThreadPool threadPool(
+        4, std::nullopt, threadpooluniverse::ThreadPool::WorkerStartup::NonBlocking );
+    std::atomic_int tasksExecuted{ 0 };
+    for( int i = 0; i < 50; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&tasksExecuted]() { tasksExecuted.fetch_add( 1 ); } ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( tasksExecuted.load(), 50 );
+
+    auto startTime = std::chrono::steady_clock::now();
+    while( !threadPool.allThreadsRunning() &&
+           std::chrono::steady_clock::now() - startTime < std::chrono::seconds( 10 ) )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    EXPECT_TRUE( threadPool.allThreadsRunning() );
+}
+
+TEST( ThreadPoolTest, CancelTasksTakenInBatch )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    std::atomic_bool firstTaskStarted{ false };
+    std::atomic_bool release{ false };
+    std::atomic_int tasksExecuted{ 0 };
+    std::vector<uint64_t> taskIds;
+    for( int i = 0; i < 100; ++i )
+    {
+        uint64_t taskId = threadPool.generateId();
+        taskIds.push_back( taskId );
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            taskId, [&firstTaskStarted, &release, &tasksExecuted]() {
+                firstTaskStarted.store( true );
+                while( !release.load() )
+                {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+                tasksExecuted.fetch_add( 1 );
+            } ) );
+    }
+    threadPool.startProcessing();
+    while( !firstTaskStarted.load() )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    // The worker has taken a batch of tasks but executes only the first one. The rest of
+    // the tasks must still be cancelable.
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 100 );
+    EXPECT_FALSE( threadPool.cancelTask( taskIds[ 0 ] ) );
+    for( size_t i = 1; i < taskIds.size(); ++i )
+    {
+        EXPECT_TRUE( threadPool.cancelTask( taskIds[ i ] ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1 );
+
+    release.store( true );
+    threadPool.waitAllTasks();
+    EXPECT_EQ( tasksExecuted.load(), 1 );
+}
+
+TEST( ThreadPoolTest, BatchedTasksAreShared )
+{
+    threadpooluniverse::ThreadPool threadPool( 4, std::nullopt );
+    std::mutex indicesMutex;
+    std::vector<int> tasksPerWorker( 4, 0 );
+    for( int i = 0; i < 400; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&]() {
+                std::this_thread::sleep_for( std::chrono::microseconds( 500 ) );
+                std::lock_guard<std::mutex> lock( indicesMutex );
+                ++tasksPerWorker[ threadPool.getCurrentWorkerIndex().value() ];
+            } ) );
+    }
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    int totalTasks = 0;
+    for( int numTasks : tasksPerWorker )
+    {
+        EXPECT_GT( numTasks, 0 );
+        totalTasks += numTasks;
+    }
+    EXPECT_EQ( totalTasks, 400 );
+}
+
+TEST( ThreadPoolTest, BlockingScopeStartsCompensatingWorkers )
+{
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    threadPool.startProcessing();
+
+    std::atomic_bool release{ false };
+    std::atomic_int blockedTasks{ 0 };
+    for( int i = 0; i < 2; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&release, &blockedTasks]() {
+                threadpooluniverse::ThreadPool::BlockingScope blockingScope;
+                blockedTasks.fetch_add( 1 );
+                while( !release.load() )
+                {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+            } ) );
+    }
+    while( blockedTasks.load() < 2 )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    // Both regular workers are blocked but the compensating workers process the new tasks.
+    std::atomic_int tasksExecuted{ 0 };
+    for( int i = 0; i < 20; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&tasksExecuted]() { tasksExecuted.fetch_add( 1 ); } ) );
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    while( tasksExecuted.load() < 20 &&
+           std::chrono::steady_clock::now() - startTime < std::chrono::seconds( 10 ) )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    EXPECT_EQ( tasksExecuted.load(), 20 );
+    EXPECT_EQ( threadPool.getNumberOfCompensatingThreads(), 2 );
+    EXPECT_EQ( threadPool.getNumberOfThreads(), 2 );
+
+    release.store( true );
+    threadPool.waitAllTasks();
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+}
+
+TEST( ThreadPoolTest, CompensatingThreadsAreCapped )
+{
+    threadpooluniverse::ThreadPool threadPool( 3, std::nullopt );
+    threadPool.setMaxCompensatingThreads( 1 );
+    threadPool.startProcessing();
+
+    std::atomic_bool release{ false };
+    std::atomic_int blockedTasks{ 0 };
+    for( int i = 0; i < 3; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&release, &blockedTasks]() {
+                threadpooluniverse::ThreadPool::BlockingScope blockingScope;
+                threadpooluniverse::ThreadPool::BlockingScope nestedScope;
+                blockedTasks.fetch_add( 1 );
+                while( !release.load() )
+                {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+            } ) );
+    }
+    while( blockedTasks.load() < 3 )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfCompensatingThreads(), 1 );
+
+    release.store( true );
+    threadPool.waitAllTasks();
+}
+
+TEST( ThreadPoolTest, BlockingScopeOutsideWorkerDoesNothing )
+{
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    {
+        threadpooluniverse::ThreadPool::BlockingScope blockingScope;
+    }
+    EXPECT_EQ( threadPool.getNumberOfCompensatingThreads(), 0 );
+}
+
+TEST( ThreadPoolTest, AdmissionControlRejectsWhenQueueDelayStaysHigh )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    threadpooluniverse::ThreadPool::AdmissionControlSettings settings;
+    settings.targetDelay = std::chrono::milliseconds( 1 );
+    settings.interval = std::chrono::milliseconds( 10 );
+    threadPool.setAdmissionControl( settings );
+    threadPool.startProcessing();
+
+    // Keep submitting slow tasks until the admission control starts rejecting them.
+    int numRejected = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    while( numRejected == 0 &&
+           std::chrono::steady_clock::now() - startTime < std::chrono::seconds( 10 ) )
+    {
+        try
+        {
+            threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+                threadPool.generateId(),
+                []() { std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) ); } ) );
+        }
+        catch( const threadpooluniverse::TaskQueueFullException& )
+        {
+            ++numRejected;
+        }
+        std::this_thread::sleep_for( std::chrono::microseconds( 500 ) );
+    }
+    EXPECT_GT( numRejected, 0 );
+    EXPECT_TRUE( threadPool.isOverloaded() );
+    EXPECT_EQ( threadPool.getNumberOfRejectedTasks(), static_cast<size_t>( numRejected ) );
+
+    // Once the queue has drained new tasks are accepted again.
+    threadPool.waitAllTasks();
+    EXPECT_NO_THROW( threadPool.pushToQueue( std::make_unique<DummyTask>( threadPool.generateId() ) ) );
+    threadPool.waitAllTasks();
+    EXPECT_FALSE( threadPool.isOverloaded() );
+}
+
+TEST( ThreadPoolTest, AdmissionControlAcceptsCheapTasks )
+{
+    threadpooluniverse::ThreadPool threadPool( 4, std::nullopt );
+    threadpooluniverse::ThreadPool::AdmissionControlSettings settings;
+    settings.targetDelay = std::chrono::milliseconds( 100 );
+    settings.interval = std::chrono::milliseconds( 100 );
+    threadPool.setAdmissionControl( settings );
+    threadPool.startProcessing();
+
+    for( int i = 0; i < 10000; ++i )
+    {
+        ASSERT_NO_THROW( threadPool.pushToQueue( std::make_unique<DummyTask>( threadPool.generateId() ) ) );
+    }
+    threadPool.waitAllTasks();
+    EXPECT_EQ( threadPool.getNumberOfRejectedTasks(), 0 );
+    EXPECT_FALSE( threadPool.isOverloaded() );
+}
+
+TEST( ThreadPoolTest, WorkerHooksAndScratchArena )
+{
+    std::atomic_int initCalls{ 0 };
+    std::atomic_int teardownCalls{ 0 };
+    std::atomic_int arenaMisses{ 0 };
+    std::atomic_int nonEmptyArenas{ 0 };
+    {
+        threadpooluniverse::ThreadPool threadPool( 3, std::nullopt );
+        threadPool.setWorkerHooks( [&initCalls]( size_t ) { initCalls.fetch_add( 1 ); },
+                                   [&teardownCalls]( size_t ) { teardownCalls.fetch_add( 1 ); } );
+        EXPECT_EQ( threadpooluniverse::ThreadPool::getCurrentScratchArena(), nullptr );
+
+        for( int i = 0; i < 300; ++i )
+        {
+            threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+                threadPool.generateId(), [&]() {
+                    auto arena = threadpooluniverse::ThreadPool::getCurrentScratchArena();
+                    if( arena == nullptr )
+                    {
+                        arenaMisses.fetch_add( 1 );
+                        return;
+                    }
+                    if( arena->getBytesAllocated() != 0 )
+                    {
+                        nonEmptyArenas.fetch_add( 1 );
+                    }
+                    int* buffer = arena->allocateArray<int>( 1000 );
+                    buffer[ 999 ] = 1;
+                } ) );
+        }
+        threadPool.startProcessing();
+        threadPool.waitAllTasks();
+        EXPECT_GE( initCalls.load(), 1 );
+        EXPECT_LE( initCalls.load(), 3 );
+        EXPECT_EQ( teardownCalls.load(), 0 );
+    }
+    EXPECT_EQ( teardownCalls.load(), initCalls.load() );
+
+    // The workers that never get a task are initialized and torn down too.
+    initCalls.store( 0 );
+    teardownCalls.store( 0 );
+    {
+        threadpooluniverse::ThreadPool threadPool( 3, std::nullopt );
+        threadPool.setWorkerHooks( [&initCalls]( size_t ) { initCalls.fetch_add( 1 ); },
+                                   [&teardownCalls]( size_t ) { teardownCalls.fetch_add( 1 ); } );
+        threadPool.startProcessing();
+        while( initCalls.load() < 3 )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+        EXPECT_EQ( teardownCalls.load(), 0 );
+    }
+    EXPECT_EQ( initCalls.load(), 3 );
+    EXPECT_EQ( teardownCalls.load(), 3 );
+    EXPECT_EQ( arenaMisses.load(), 0 );
+    EXPECT_EQ( nonEmptyArenas.load(), 0 );
+}
+
+TEST( ThreadPoolTest, CoalesceKeyedTasks )
+{
+    using CoalescePolicy = threadpooluniverse::ThreadPool::CoalescePolicy;
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    std::vector<int> executed;
+    std::mutex executedMutex;
+    auto makeTask = [&]( int value ) {
+        return std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&executed, &executedMutex, value]() {
+                std::lock_guard<std::mutex> lock( executedMutex );
+                executed.push_back( value );
+            } );
+    };
+
+    uint64_t firstId = threadPool.pushToQueue( makeTask( 1 ), "first", CoalescePolicy::KeepFirst );
+    EXPECT_EQ( threadPool.pushToQueue( makeTask( 2 ), "first", CoalescePolicy::KeepFirst ), firstId );
+    threadPool.pushToQueue( makeTask( 3 ), "last", CoalescePolicy::KeepLast );
+    threadPool.pushToQueue( makeTask( 4 ), "last", CoalescePolicy::KeepLast );
+    threadPool.pushToQueue( makeTask( 5 ), "other", CoalescePolicy::KeepLast );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 3 );
+    EXPECT_EQ( threadPool.getNumberOfCoalescedTasks(), 2 );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    std::sort( executed.begin(), executed.end() );
+    EXPECT_EQ( executed, std::vector<int>( { 1, 4, 5 } ) );
+
+    // After the task has been executed, the key gets queued again.
+    threadPool.pushToQueue( makeTask( 6 ), "first", CoalescePolicy::KeepFirst );
+    threadPool.waitAllTasks();
+    EXPECT_EQ( executed.size(), 4 );
+}
+
+TEST( ThreadPoolTest, KeyedTasksAreNotCoalescedWithRejectedTask )
+{
+    using CoalescePolicy = threadpooluniverse::ThreadPool::CoalescePolicy;
+    // The processing is not started so the queue stays full.
+    threadpooluniverse::ThreadPool threadPool( 1, 1 );
+    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>( threadPool.generateId(), []() {} ) );
+
+    std::atomic_int numAccepted{ 0 };
+    std::atomic_int numRejected{ 0 };
+    std::vector<std::thread> threads;
+    for( int i = 0; i < 8; ++i )
+    {
+        threads.emplace_back( [&]() {
+            for( int j = 0; j < 200; ++j )
+            {
+                try
+                {
+                    threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+                                                threadPool.generateId(), []() {} ),
+                                            "key", CoalescePolicy::KeepLast );
+                    numAccepted.fetch_add( 1 );
+                }
+                catch( const threadpooluniverse::TaskQueueFullException& )
+                {
+                    numRejected.fetch_add( 1 );
+                }
+            }
+        } );
+    }
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    // Every push is reported as rejected because the key never got a queued task.
+    EXPECT_EQ( numAccepted.load(), 0 );
+    EXPECT_EQ( numRejected.load(), 8 * 200 );
+    EXPECT_EQ( threadPool.getNumberOfCoalescedTasks(), 0 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1 );
+}
+
+namespace
+{
+    class CountingTask : public threadpooluniverse::TaskBase
+    {
+    public:
+        CountingTask( uint64_t taskId, std::atomic_int& result ) :
+            TaskBase( taskId ),
+            mResult( result )
+        {
+        }
+
+        virtual void execute() override
+        {
+            mResult.fetch_add( mCount );
+        }
+
+        int mCount{ 1 };
+
+    private:
+        std::atomic_int& mResult;
+    };
+}  // namespace
+
+TEST( ThreadPoolTest, MergeKeyedTasks )
+{
+    using CoalescePolicy = threadpooluniverse::ThreadPool::CoalescePolicy;
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    std::atomic_int result{ 0 };
+    auto merge = []( threadpooluniverse::TaskBase& queuedTask,
+                     std::unique_ptr<threadpooluniverse::TaskBase> newTask ) {
+        static_cast<CountingTask&>( queuedTask ).mCount +=
+            static_cast<CountingTask&>( *newTask ).mCount;
+    };
+    for( int i = 0; i < 10; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<CountingTask>( threadPool.generateId(), result ),
+                                "merged", CoalescePolicy::Merge, merge );
+    }
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1 );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( result.load(), 10 );
+}
+
+TEST( ThreadPoolTest, CancelKeyedTask )
+{
+    using CoalescePolicy = threadpooluniverse::ThreadPool::CoalescePolicy;
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    std::atomic_int result{ 0 };
+    uint64_t taskId = threadPool.pushToQueue(
+        std::make_unique<CountingTask>( threadPool.generateId(), result ), "key",
+        CoalescePolicy::KeepFirst );
+    EXPECT_TRUE( threadPool.cancelTask( taskId ) );
+
+    // The canceled task does not capture the new tasks with the same key.
+    threadPool.pushToQueue( std::make_unique<CountingTask>( threadPool.generateId(), result ), "key",
+                            CoalescePolicy::KeepFirst );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( result.load(), 1 );
+    EXPECT_EQ( threadPool.getNumberOfCoalescedTasks(), 0 );
+}
+
+namespace
+{
+    /**
+     * Serializable task that records its value when executed. Negative values cannot be
+     * serialized.
+     */
+    class RecordingTask : public threadpooluniverse::SerializableTask
+    {
+    public:
+        RecordingTask( uint64_t taskId, int value, std::vector<int>& executedValues, std::mutex& mutex ) :
+            SerializableTask( taskId ),
+            mValue( value ),
+            mExecutedValues( executedValues ),
+            mMutex( mutex )
+        {
+        }
+
+        virtual void execute() override
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mExecutedValues.push_back( mValue );
+        }
+
+        virtual void serialize( std::vector<char>& buffer ) const override
+        {
+            if( mValue < 0 )
+            {
+                throw std::runtime_error( "Cannot serialize negative values." );
+            }
+            buffer.resize( sizeof( mValue ) );
+            std::memcpy( buffer.data(), &mValue, sizeof( mValue ) );
+        }
+
+    private:
+        int mValue;
+        std::vector<int>& mExecutedValues;
+        std::mutex& mMutex;
+    };
+
+    threadpooluniverse::ThreadPool::SpillSettings makeSpillSettings( size_t highWaterMark,
+                                                                      std::vector<int>& executedValues,
+                                                                      std::mutex& mutex )
+    {
+        threadpooluniverse::ThreadPool::SpillSettings settings;
+        settings.directory = std::filesystem::temp_directory_path().string();
+        settings.highWaterMark = highWaterMark;
+        settings.deserializer = [&executedValues, &mutex]( uint64_t taskId, const std::vector<char>& data ) {
+            int value = 0;
+            std::memcpy( &value, data.data(), sizeof( value ) );
+            return std::make_unique<RecordingTask>( taskId, value, executedValues, mutex );
+        };
+        return settings;
+    }
+}  // namespace
+
+TEST( ThreadPoolTest, SpillTasksAboveHighWaterMark )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, 8 );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    threadPool.setSpill( makeSpillSettings( 4, executedValues, mutex ) );
+
+    // The spilled tasks are not limited by the maximum queue size.
+    for( int i = 0; i < 1000; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), i, executedValues, mutex ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 996 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1000 );
+
+    // Tasks that are not serializable bypass the spill file.
+    std::atomic_int executed{ 0 };
+    std::atomic_int expired{ 0 };
+    threadPool.pushToQueue( std::make_unique<ExpiryCountingTask>( threadPool.generateId(), executed, expired ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 996 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 1001 );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( executed.load(), 1 );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 0 );
+    ASSERT_EQ( executedValues.size(), 1000 );
+    for( int i = 0; i < 1000; ++i )
+    {
+        EXPECT_EQ( executedValues[ i ], i );
+    }
+}
+
+TEST( ThreadPoolTest, CancelAndRestoreSpilledTasks )
+{
+    threadpooluniverse::ThreadPool threadPool( 2, std::nullopt );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    threadPool.setSpill( makeSpillSettings( 2, executedValues, mutex ) );
+
+    std::vector<uint64_t> taskIds;
+    for( int i = 0; i < 6; ++i )
+    {
+        taskIds.push_back( threadPool.generateId() );
+        threadPool.pushToQueue( std::make_unique<RecordingTask>( taskIds.back(), i, executedValues, mutex ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 4 );
+    EXPECT_TRUE( threadPool.cancelTask( taskIds[ 3 ] ) );
+    EXPECT_FALSE( threadPool.cancelTask( taskIds[ 3 ] ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 3 );
+
+    // Disabling the spill reads the tasks back to the queue.
+    threadPool.setSpill( std::nullopt );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 0 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 5 );
+
+    threadPool.setSpill( makeSpillSettings( 0, executedValues, mutex ) );
+    threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), 6, executedValues, mutex ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 1 );
+    threadPool.clearQueue();
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 0 );
+
+    threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), 7, executedValues, mutex ) );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( executedValues, std::vector<int>{ 7 } );
+}
+
+TEST( ThreadPoolTest, TaskThatCannotBeSpilledIsKeptInMemory )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, 2 );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    threadPool.setSpill( makeSpillSettings( 1, executedValues, mutex ) );
+
+    threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), 0, executedValues, mutex ) );
+    threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), 1, executedValues, mutex ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 1 );
+
+    // The failed serialization falls back to the queue, which has room for one more task.
+    threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), -1, executedValues, mutex ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 1 );
+    EXPECT_EQ( threadPool.getNumberOfTasks(), 3 );
+
+    // Then the queue limit applies.
+    EXPECT_THROW( threadPool.pushToQueue(
+                      std::make_unique<RecordingTask>( threadPool.generateId(), -2, executedValues, mutex ) ),
+                  threadpooluniverse::TaskQueueFullException );
+    auto rejectedTask = threadPool.tryPushToQueue(
+        std::make_unique<RecordingTask>( threadPool.generateId(), -3, executedValues, mutex ) );
+    EXPECT_NE( rejectedTask, nullptr );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    std::sort( executedValues.begin(), executedValues.end() );
+    EXPECT_EQ( executedValues, std::vector<int>( { -1, 0, 1 } ) );
+}
+
+TEST( ThreadPoolTest, SpillDeserializerCanUseThreadPool )
+{
+    // One worker so that the tasks are executed in the order they were pushed.
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    std::atomic_int numFollowUpTasks{ 0 };
+    auto settings = makeSpillSettings( 2, executedValues, mutex );
+    auto deserializer = settings.deserializer;
+    settings.deserializer = [&, deserializer]( uint64_t taskId, const std::vector<char>& data ) {
+        // Calling the thread pool would deadlock if the queue lock was held.
+        EXPECT_GT( threadPool.getNumberOfTasks(), 0 );
+        threadPool.pushToQueue( std::make_unique<threadpooluniverse::CallbackTask>(
+            threadPool.generateId(), [&numFollowUpTasks]() { numFollowUpTasks.fetch_add( 1 ); } ) );
+        return deserializer( taskId, data );
+    };
+    threadPool.setSpill( settings );
+
+    for( int i = 0; i < 20; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), i, executedValues, mutex ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 18 );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( numFollowUpTasks.load(), 18 );
+    ASSERT_EQ( executedValues.size(), 20 );
+    for( int i = 0; i < 20; ++i )
+    {
+        EXPECT_EQ( executedValues[ i ], i );
+    }
+}
+
+TEST( ThreadPoolTest, SpillDeserializerCanSetDeadline )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    threadPool.setExpiryPolicy( threadpooluniverse::ThreadPool::ExpiryPolicy::DropExpired );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    auto settings = makeSpillSettings( 2, executedValues, mutex );
+    auto deserializer = settings.deserializer;
+    settings.deserializer = [deserializer]( uint64_t taskId, const std::vector<char>& data ) {
+        auto task = deserializer( taskId, data );
+        task->setDeadline( threadpooluniverse::TaskBase::Clock::now() - std::chrono::seconds( 1 ) );
+        return task;
+    };
+    threadPool.setSpill( settings );
+
+    for( int i = 0; i < 10; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), i, executedValues, mutex ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 8 );
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+
+    // The restored tasks keep the deadline given by the deserializer and are dropped.
+    EXPECT_EQ( executedValues, std::vector<int>( { 0, 1 } ) );
+    EXPECT_EQ( threadPool.getNumberOfExpiredTasks(), 8 );
+}
+
+TEST( ThreadPoolTest, TasksWithDeadlineAreNotSpilled )
+{
+    threadpooluniverse::ThreadPool threadPool( 1, std::nullopt );
+    threadPool.setSchedulingPolicy( threadpooluniverse::ThreadPool::SchedulingPolicy::EarliestDeadlineFirst );
+    std::vector<int> executedValues;
+    std::mutex mutex;
+    threadPool.setSpill( makeSpillSettings( 1, executedValues, mutex ) );
+
+    for( int i = 0; i < 5; ++i )
+    {
+        threadPool.pushToQueue( std::make_unique<RecordingTask>( threadPool.generateId(), i, executedValues, mutex ) );
+    }
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 4 );
+
+    // The urgent task stays in the queue and is executed before the spilled tasks.
+    auto urgentTask = std::make_unique<RecordingTask>( threadPool.generateId(), 100, executedValues, mutex );
+    urgentTask->setDeadline( threadpooluniverse::TaskBase::Clock::now() + std::chrono::hours( 1 ) );
+    threadPool.pushToQueue( std::move( urgentTask ) );
+    EXPECT_EQ( threadPool.getNumberOfSpilledTasks(), 4 );
+
+    threadPool.startProcessing();
+    threadPool.waitAllTasks();
+    EXPECT_EQ( executedValues, std::vector<int>( { 100, 0, 1, 2, 3, 4 } ) );
+}